@@ -0,0 +1,207 @@
+//
+//  A small timing harness shared by the bench_swl_* targets.
+//
+//  Each case is run a few times to warm up, then timed for a number of repetitions.
+//  Results (min/median/p99/mean per repetition, and per item) are printed to stdout
+//  as a single JSON document; a human-readable summary goes to stderr.
+//
+//  Command line options:
+//      --reps N        timed repetitions per case (default 100)
+//      --warmup N      untimed repetitions per case (default 5)
+//      --filter TEXT   only run cases whose name contains TEXT
+//
+
+#ifndef BENCH_BENCHMARK_HPP
+#define BENCH_BENCHMARK_HPP
+
+#include "widgets/application.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief   Runs and reports benchmark cases
+ *
+ * @note    Usage:
+ *              int main(int argc, const char* argv[])
+ *              {
+ *                  BenchRunner bench("bench_swl_example", argc, argv);
+ *                  bench.run("case", items, [&] { ... });
+ *                  return bench.report();
+ *              }
+ */
+class BenchRunner
+{
+public:
+    struct Result
+    {
+        std::string name;
+        std::size_t items;  //  work items per repetition (e.g. children visited), for per-item times
+        int reps;
+        double min_ns;
+        double median_ns;
+        double p99_ns;
+        double mean_ns;
+    };
+
+public:
+    /// constructors:
+    BenchRunner(std::string const& suite, int argc, const char* argv[]);
+
+    /// modifiers:
+    /**
+     * @brief   Times `f`, unless the case is filtered out
+     * @param   items The amount of work done by one call of `f`
+     */
+    template<class F>
+    void run(std::string const& name, std::size_t items, F&& f);
+
+    /**
+     * @brief   Prints the results as JSON
+     * @return  An exit code for main()
+     */
+    int report() const;
+
+    /// accessors:
+    bool enabled(std::string const& name) const;
+
+private:
+    std::string m_suite;
+    int m_reps;
+    int m_warmup;
+    std::string m_filter;
+    std::vector<Result> m_results;
+
+private:
+    static double percentile(std::vector<double> const& sorted, double p);
+    static std::string escape(std::string const& str);
+};
+
+
+/**
+ * @brief   A headless application to render benchmarks with (software renderer, no window)
+ */
+class BenchApplication : public Application
+{
+public:
+    BenchApplication(int width = 800, int height = 600)
+        : Application({0, 0, width, height}, "bench", SDL_WINDOW_HIDDEN, 0, true)
+    {
+    }
+
+    /// @brief  Waits for queued render commands to execute, so that they're included in timings
+    void flush() const
+    {
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+        SDL_RenderFlush(get_renderer().get());
+#endif
+    }
+};
+
+
+/// constructors:
+inline BenchRunner::BenchRunner(std::string const& suite, int argc, const char* argv[])
+    : m_suite{suite}
+    , m_reps{100}
+    , m_warmup{5}
+{
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (std::strcmp(argv[i], "--reps") == 0)
+            m_reps = std::max(1, std::atoi(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--warmup") == 0)
+            m_warmup = std::max(0, std::atoi(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--filter") == 0)
+            m_filter = argv[i + 1];
+    }
+}
+
+/// modifiers:
+template<class F>
+void BenchRunner::run(std::string const& name, std::size_t items, F&& f)
+{
+    using Clock = std::chrono::steady_clock;
+
+    if (!enabled(name))
+        return;
+
+    for (int i = 0; i < m_warmup; ++i)
+        f();
+
+    std::vector<double> samples;
+    samples.reserve(m_reps);
+    for (int i = 0; i < m_reps; ++i)
+    {
+        const auto start = Clock::now();
+        f();
+        const auto end = Clock::now();
+        samples.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+    }
+
+    std::sort(samples.begin(), samples.end());
+    double total = 0;
+    for (auto sample : samples)
+        total += sample;
+
+    Result result{name, std::max<std::size_t>(items, 1), m_reps,
+                  samples.front(), percentile(samples, 0.5), percentile(samples, 0.99), total / samples.size()};
+    m_results.push_back(result);
+
+    std::cerr << m_suite << "/" << name << ": median " << result.median_ns / 1000 << " us"
+              << " (" << result.median_ns / result.items << " ns/item, min " << result.min_ns / 1000
+              << " us, p99 " << result.p99_ns / 1000 << " us)" << std::endl;
+}
+
+inline int BenchRunner::report() const
+{
+    std::cout << "{\"suite\": \"" << escape(m_suite) << "\", \"results\": [";
+    for (std::size_t i = 0; i < m_results.size(); ++i)
+    {
+        auto const& r = m_results[i];
+        std::cout << (i ? ", " : "") << "\n  {\"name\": \"" << escape(r.name) << "\""
+                  << ", \"reps\": " << r.reps
+                  << ", \"items\": " << r.items
+                  << ", \"min_ns\": " << r.min_ns
+                  << ", \"median_ns\": " << r.median_ns
+                  << ", \"p99_ns\": " << r.p99_ns
+                  << ", \"mean_ns\": " << r.mean_ns
+                  << ", \"median_ns_per_item\": " << r.median_ns / r.items << "}";
+    }
+    std::cout << "\n]}" << std::endl;
+    return 0;
+}
+
+/// accessors:
+inline bool BenchRunner::enabled(std::string const& name) const
+{
+    return m_filter.empty() || name.find(m_filter) != std::string::npos;
+}
+
+/// helper functions:
+inline double BenchRunner::percentile(std::vector<double> const& sorted, double p)
+{
+    //  nearest-rank
+    const auto rank = static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+inline std::string BenchRunner::escape(std::string const& str)
+{
+    std::string result;
+    for (auto c : str)
+    {
+        if (c == '"' || c == '\\')
+            result += '\\';
+        result += c;
+    }
+    return result;
+}
+
+
+#endif
@@ -0,0 +1,117 @@
+//
+//  Benchmarks the canvas hot paths on a headless application:
+//   * "render_children/N" renders a canvas of N coloured rects with the software renderer.
+//   * "render_column/{unculled,culled}/N" render a column of N rows, most of which lie below the
+//     bottom edge, without and with viewport culling.
+//   * "render_stacked/{unculled,occluded}/N" render N rects covered by an opaque page,
+//     without and with occlusion culling.
+//   * "dispatch/linear/N" and "dispatch/spatial/N" route a mouse motion event through N children,
+//     without and with a spatial index.
+//
+//  Usage: bench_swl_canvas [--reps N] [--warmup N] [--filter TEXT]
+//
+
+#include "benchmark.hpp"
+
+#include "widgets/canvas.hpp"
+#include "widgets/rectitem.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+
+/// @brief  Fills `canvas` with `count` 8x6 rects, row by row in a 100x100 grid (800x600, so up to 10000 rects don't overlap)
+void populate(Canvas& canvas, std::size_t count)
+{
+    std::vector<WidgetItem*> items;
+    items.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        auto item = new RectItem({int(i % 100) * 8, int(i / 100 % 100) * 6, 8, 6});
+        item->background({Uint8(i * 7), Uint8(i * 13), Uint8(i * 29), 255});
+        items.push_back(item);
+    }
+    canvas.reserve(count);
+    canvas.add_items(items);
+}
+
+
+int main(int argc, const char * argv[])
+{
+    BenchApplication app;
+    BenchRunner bench("bench_swl_canvas", argc, argv);
+    
+    for (std::size_t count : {100u, 1000u, 10000u})
+    {
+        const auto suffix = "/" + std::to_string(count);
+        
+        Canvas canvas(app.width(), app.height());
+        populate(canvas, count);
+        bench.run("render_children" + suffix, count, [&]
+        {
+            canvas.render_children(app.get_renderer());
+            app.flush();
+        });
+        
+        Canvas column(app.width(), app.height());
+        for (std::size_t i = 0; i < count; ++i)
+            column.add_item(new RectItem({0, int(i) * 20, app.width(), 20}));
+        column.viewport_culling(false);
+        bench.run("render_column/unculled" + suffix, count, [&]
+        {
+            column.render_children(app.get_renderer());
+            app.flush();
+        });
+        column.viewport_culling(true);
+        bench.run("render_column/culled" + suffix, count, [&]
+        {
+            column.render_children(app.get_renderer());
+            app.flush();
+        });
+        
+        Canvas stacked(app.width(), app.height());
+        populate(stacked, count);
+        stacked.add_item(new RectItem({0, 0, app.width(), app.height()}));
+        bench.run("render_stacked/unculled" + suffix, count, [&]
+        {
+            stacked.render_children(app.get_renderer());
+            app.flush();
+        });
+        stacked.occlusion_culling(true);
+        bench.run("render_stacked/occluded" + suffix, count, [&]
+        {
+            stacked.render_children(app.get_renderer());
+            app.flush();
+        });
+        
+        Canvas indexed(app.width(), app.height());
+        indexed.spatial_index();
+        populate(indexed, count);
+        
+        //  alternate between the first two children, so the hit cache doesn't short-circuit every event:
+        //  being at the bottom, they're found after scanning (almost) every child, whatever the count
+        SDL_MouseMotionEvent motion;
+        SDL_zero(motion);
+        motion.type = SDL_MOUSEMOTION;
+        motion.x = 4;
+        motion.y = 3;
+        const MouseEvent first{motion};
+        motion.x = 12;
+        motion.y = 3;
+        const MouseEvent second{motion};
+        
+        bench.run("dispatch/linear" + suffix, count, [&]
+        {
+            canvas.handle_mouse_event(first);
+            canvas.handle_mouse_event(second);
+        });
+        bench.run("dispatch/spatial" + suffix, count, [&]
+        {
+            indexed.handle_mouse_event(first);
+            indexed.handle_mouse_event(second);
+        });
+    }
+    
+    return bench.report();
+}
@@ -0,0 +1,140 @@
+//
+//  Benchmarks list models and views on a headless application:
+//   * "add_items/N" bulk-adds N items to an empty model.
+//   * "sort_once/N" sorts a model of N items, alternating between two orders so that every run does work.
+//   * "render/N" renders a ListView (header and visible rows) over a model of N items.
+//   * "render_batched/N" does the same through a RenderBatch.
+//  After each render case, the number of renderer state changes issued and skipped per frame is printed to stderr.
+//
+//  Usage: bench_swl_listview [--reps N] [--warmup N] [--filter TEXT]
+//
+
+#include "benchmark.hpp"
+
+#include "models/listmodel.hpp"
+#include "widgets/listview.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+
+const std::string fontpath = "demos/fonts/luxisr.ttf";
+
+
+struct Employee : public ListItem
+{
+    int id;
+    std::string first_name;
+    std::string last_name;
+    std::string role;
+    
+    Employee(int id, std::string const& first_name, std::string const& last_name, std::string const& role)
+        : id{id}, first_name{first_name}, last_name{last_name}, role{role}
+    {
+    }
+    
+    /// accessors:
+    virtual std::size_t fields() const override { return 4; }
+    virtual std::string field_at(int index) const override
+    {
+        switch (index)
+        {
+        case 0:     return std::to_string(id);
+        case 1:     return first_name;
+        case 2:     return last_name;
+        case 3:     return role;
+        default:    return "";
+        }
+    }
+};
+
+
+std::vector<Employee> make_employees(std::size_t count)
+{
+    std::vector<Employee> employees;
+    employees.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+        employees.push_back({int(i), std::string(3, 'A' + i % 26), std::string(5, 'a' + i * 7 % 26), std::to_string(i % 10)});
+    
+    std::mt19937 rng(42);
+    std::shuffle(employees.begin(), employees.end(), rng);
+    return employees;
+}
+
+
+int main(int argc, const char * argv[])
+{
+    BenchApplication app;
+    BenchRunner bench("bench_swl_listview", argc, argv);
+    
+    const auto header_font = app.add_font(fontpath, 18, {0, 0, 0, 255});
+    const auto item_font = app.add_font(fontpath, 14, {0, 0, 0, 255});
+    
+    const auto by_name = [](Employee const& a, Employee const& b) { return a.last_name < b.last_name; };
+    const auto by_id = [](Employee const& a, Employee const& b) { return a.id < b.id; };
+    
+    for (std::size_t count : {100u, 1000u, 10000u})
+    {
+        const auto suffix = "/" + std::to_string(count);
+        const auto employees = make_employees(count);
+        
+        bench.run("add_items" + suffix, count, [&]
+        {
+            ListModel<Employee> model;
+            model.add_items(employees);
+        });
+        
+        ListModel<Employee> model;
+        model.add_items(employees);
+        bool flip = false;
+        bench.run("sort_once" + suffix, count, [&]
+        {
+            flip = !flip;
+            if (flip)
+                model.sort_once(by_name);
+            else
+                model.sort_once(by_id);
+        });
+        
+        ListView<Employee> listview({0, 0, app.width(), app.height()}, &model);
+        listview.headers({"ID", "First", "Last", "Job"}).header_font(header_font).header_height(30);
+        listview.item_font(item_font).item_height(20);
+        listview.column_ratios({1, 2, 2, 4});
+        
+        const auto rows = std::min<std::size_t>(count, (app.height() - 30) / 20);
+        auto& state = RenderState::of(app.get_renderer().get());
+        auto report_state = [&](std::string const& name, bool batched)
+        {
+            if (!bench.enabled(name))
+                return;
+            
+            state.reset_counters();
+            {
+                std::unique_ptr<RenderBatch> batch{batched ? new RenderBatch{app.get_renderer()} : nullptr};
+                listview.render(app.get_renderer());
+            }
+            std::cerr << "    state changes: " << state.issued() << " issued, " << state.saved() << " skipped" << std::endl;
+        };
+        
+        bench.run("render" + suffix, rows, [&]
+        {
+            listview.render(app.get_renderer());
+            app.flush();
+        });
+        report_state("render" + suffix, false);
+        bench.run("render_batched" + suffix, rows, [&]
+        {
+            {
+                RenderBatch batch{app.get_renderer()};
+                listview.render(app.get_renderer());
+            }
+            app.flush();
+        });
+        report_state("render_batched" + suffix, true);
+    }
+    
+    return bench.report();
+}
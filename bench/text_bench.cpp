@@ -0,0 +1,107 @@
+//
+//  Benchmarks text rendering on a headless application:
+//   * "draw_text/<length>" draws a string of the given length, aligned in a box.
+//   * "text_item/<length>" draws the same string through a TextItem, which reuses its cached layout.
+//   * "glyph_lookup/ascii", "glyph_lookup/latin1" and "glyph_lookup/latin_ext" fetch cached glyph data
+//     for U+0020-U+007E, U+00A0-U+00FF (both indexed directly) and U+0100-U+017F (hashed).
+//   * "measure/<length>" measures the width of a string with FC_GetWidth() (formatted),
+//     "measure_text/<length>" with FC_MeasureText() (unformatted).
+//   * "first_draw/lazy" loads a font and draws Latin-1 text with it, rasterizing glyphs as they're drawn;
+//     "first_draw/preloaded" rasterizes Charset::LATIN_1 on a GlyphLoader worker and uploads it first
+//     (waiting for the worker is included, so this is the worst case: nothing else ran meanwhile).
+//
+//  Usage: bench_swl_text [--reps N] [--warmup N] [--filter TEXT]
+//
+
+#include "benchmark.hpp"
+
+#include "glyphloader.hpp"
+#include "utility.hpp"
+#include "widgets/textitem.hpp"
+
+#include <string>
+
+
+const std::string fontpath = "demos/fonts/luxisr.ttf";
+
+
+/// @return The codepoint FontCache uses for `unicode` (its packed UTF-8 bytes), for codepoints below U+0800
+Uint32 packed(Uint32 unicode)
+{
+    return unicode < 0x80 ? unicode : ((0xC0 | (unicode >> 6)) << 8) | (0x80 | (unicode & 0x3F));
+}
+
+
+int main(int argc, const char * argv[])
+{
+    BenchApplication app;
+    BenchRunner bench("bench_swl_text", argc, argv);
+    
+    const auto font = app.add_font(fontpath, 16, {0, 0, 0, 255}).lock();
+    if (!font)
+    {
+        std::cerr << "could not load " << fontpath << " (run from the repository root)" << std::endl;
+        return 1;
+    }
+    
+    for (std::size_t length : {8u, 64u, 512u})
+    {
+        std::string text;
+        for (std::size_t i = 0; i < length; ++i)
+            text += char('a' + i % 26);
+        
+        const auto suffix = "/" + std::to_string(length);
+        bench.run("draw_text" + suffix, length, [&]
+        {
+            draw_text(app.get_renderer(), {0, 0, app.width(), app.height()}, font, text, ALIGN_CENTER);
+            app.flush();
+        });
+        TextItem item({0, 0, app.width(), app.height()});
+        item.text(text, font, ALIGN_CENTER);
+        bench.run("text_item" + suffix, length, [&]
+        {
+            item.render(app.get_renderer());
+            app.flush();
+        });
+        bench.run("measure" + suffix, length, [&]
+        {
+            volatile Uint16 width = FC_GetWidth(font.get(), "%s", text.c_str());
+            (void)width;
+        });
+        bench.run("measure_text" + suffix, length, [&]
+        {
+            volatile int width = FC_MeasureText(font.get(), text.data(), text.size()).w;
+            (void)width;
+        });
+    }
+    
+    const auto lookup = [&](Uint32 first, Uint32 last)
+    {
+        FC_GlyphData data;
+        for (Uint32 codepoint = first; codepoint < last; ++codepoint)
+            FC_GetGlyphData(font.get(), &data, packed(codepoint));
+    };
+    bench.run("glyph_lookup/ascii", 0x7F - 0x20, [&] { lookup(0x20, 0x7F); });
+    bench.run("glyph_lookup/latin1", 0x100 - 0xA0, [&] { lookup(0xA0, 0x100); });
+    bench.run("glyph_lookup/latin_ext", 0x180 - 0x100, [&] { lookup(0x100, 0x180); });
+    
+    const std::string latin1 = Charset::LATIN_1;
+    const SDL_Rect box{0, 0, app.width(), app.height()};
+    bench.run("first_draw/lazy", latin1.size(), [&]
+    {
+        const auto fresh = make_shared_font(app.get_renderer(), fontpath, 16, {0, 0, 0, 255});
+        draw_text(app.get_renderer(), box, fresh, latin1, ALIGN_CENTER);
+        app.flush();
+    });
+    bench.run("first_draw/preloaded", latin1.size(), [&]
+    {
+        GlyphLoader loader;
+        const auto fresh = make_shared_font(app.get_renderer(), fontpath, 16, {0, 0, 0, 255}, TTF_STYLE_NORMAL, "");
+        loader.load(fresh, fontpath, 16, TTF_STYLE_NORMAL, latin1);
+        loader.upload();
+        draw_text(app.get_renderer(), box, fresh, latin1, ALIGN_CENTER);
+        app.flush();
+    });
+    
+    return bench.report();
+}
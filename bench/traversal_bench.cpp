@@ -0,0 +1,81 @@
+//
+//  Measures the per-child cost of traversing a canvas with many children:
+//   * "std_function/N" visits N children through foreach_child() + std::bind (the old render/event path).
+//   * "template/N" visits N children through for_each_child() with a lambda (the current path).
+//   * "render_children/N" and "handle_mouse_event/N" time the actual hot paths.
+//  Per-item times are per child.
+//
+//  Usage: bench_swl_traversal [--reps N] [--warmup N] [--filter TEXT]
+//
+
+#include "benchmark.hpp"
+
+#include "widgets/canvas.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief   A minimal item which only counts how often it was visited
+ */
+class CountingItem : public WidgetItem
+{
+public:
+    static unsigned long long visits;
+
+    CountingItem(SDL_Rect const& dimensions) : WidgetItem(dimensions) {}
+
+    virtual bool handle_mouse_event(MouseEvent const& event) override
+    {
+        ++visits;
+        return WidgetItem::handle_mouse_event(event);
+    }
+
+    virtual void render(Renderer const&) const override { ++visits; }
+};
+
+unsigned long long CountingItem::visits = 0;
+
+
+int main(int argc, const char * argv[])
+{
+    BenchRunner bench("bench_swl_traversal", argc, argv);
+    
+    const Renderer renderer{nullptr};
+    
+    SDL_MouseMotionEvent motion;
+    SDL_zero(motion);
+    motion.type = SDL_MOUSEMOTION;
+    const MouseEvent event{motion};
+    
+    for (std::size_t children : {1000u, 10000u})
+    {
+        const auto suffix = "/" + std::to_string(children);
+        
+        Canvas canvas(1000, 1000);
+        canvas.reserve(children);
+        
+        std::vector<WidgetItem*> items;
+        items.reserve(children);
+        for (std::size_t i = 0; i < children; ++i)
+            items.push_back(new CountingItem({int(i % 100) * 10, int(i / 100 % 100) * 10, 10, 10}));
+        canvas.add_items(items);
+        
+        const Canvas& const_canvas = canvas;
+        bench.run("std_function" + suffix, children, [&]
+        {
+            using namespace std::placeholders;
+            const_canvas.foreach_child(std::bind(&WidgetItem::render, _1, std::cref(renderer)), Canvas::VISIBLE);
+        });
+        bench.run("template" + suffix, children, [&]
+        {
+            const_canvas.for_each_child([&renderer](WidgetItem* child) { child->render(renderer); }, Canvas::VISIBLE);
+        });
+        bench.run("render_children" + suffix, children, [&] { canvas.render_children(renderer); });
+        bench.run("handle_mouse_event" + suffix, children, [&] { canvas.handle_mouse_event(event); });
+    }
+    
+    return bench.report();
+}
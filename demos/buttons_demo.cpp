@@ -42,7 +42,7 @@ int main(int argc, const char * argv[])
     try
     {
         DemoApplication app;
-        return app.run();
+        return app.run(argc, argv);
     }
     catch (std::runtime_error& err)
     {
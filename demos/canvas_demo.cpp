@@ -92,7 +92,7 @@ int main(int argc, const char * argv[])
     try
     {
         DemoApplication app;
-        return app.run();
+        return app.run(argc, argv);
     }
     catch (std::runtime_error& err)
     {
@@ -163,14 +163,12 @@ void DemoApplication::init_widgets()
     lview->header_height(40).item_height(20);
     lview->headers({"Class", "HP", "Str", "Amr"}).column_ratios({2, 1, 1, 1});
     lview->selection_color(Colors::LIGHT_BLUE);
-    lview->on_index_clicked([this, canvas](int index)
+    lview->on_index_clicked([this](int index)
     {
         if (index != -1)
         {
             std::cout << "canvas 3: index " << index << " clicked" << std::endl;
             model.toggle_select(index);
-            canvas[3]->redraw();
         }
     });
-    lview->on_scrolled([canvas](WheelEvent const&) { canvas[3]->redraw(); });
 }
@@ -0,0 +1,185 @@
+/*
+ *      Copyright (C) 2020 Johnathan Law
+ *
+ *      This file is part of SWL.
+ *
+ *      SWL is free software: you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation, either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      SWL is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with SWL.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DISPLAYLIST_HPP
+#define DISPLAYLIST_HPP
+
+#include "types.hpp"
+
+#include "sdl_inc.hpp"
+
+#include <vector>
+
+
+/**
+ * @brief   A retained list of draw commands, split into slices (one per child of a Canvas,
+ *          see Canvas::display_list()). A slice is recorded while its child renders and is
+ *          replayed on later frames without calling the child's render() again, until the
+ *          slice is invalidated.
+ *
+ * @note    Usage:
+ *              if (list.is_recorded(i))
+ *                  list.replay(renderer, i);
+ *              else
+ *              {
+ *                  list.begin(i);
+ *                  child->render(renderer);    //  draws as usual, and is recorded
+ *                  list.end();
+ *              }
+ *
+ * @note    Recording relies on the render utility functions (draw_rect(), draw_filled_rect(),
+ *          render_texture(), and text drawn through FontCache, see render_glyph_run()): they append to the list that is
+ *          recording, if any. Drawing done by calling SDL directly is not recorded. Utilities
+ *          which draw from temporary textures (e.g. render_surface()) or can't be batched (flipped
+ *          text, see render_glyph()) mark the slice as volatile: volatile slices are never replayed,
+ *          their child is rendered every time.
+ *
+ * @note    Textures referenced by commands (e.g. glyph atlases, canvas textures) must outlive
+ *          the slice, or the slice must be invalidated before they are destroyed.
+ */
+class DisplayList
+{
+public:
+    /// constructors:
+    DisplayList() noexcept;
+    DisplayList(DisplayList const&) = delete;
+    
+    /// destructor:
+    ~DisplayList();
+    
+    /// modifiers:
+    /**
+     * @brief   Starts recording slice `index`, discarding what it held
+     */
+    void begin(std::size_t index);
+    
+    /**
+     * @brief   Stops recording
+     */
+    void end();
+    
+    /**
+     * @brief   Discards slice `index`, so that it gets recorded again
+     */
+    void invalidate(std::size_t index);
+    
+    /**
+     * @brief   Discards all slices
+     */
+    void clear();
+    
+    /// recording functions:
+    void fill_rect(SDL_Rect const& rect, SDL_Color const& color);
+    void outline_rect(SDL_Rect const& rect, SDL_Color const& color);
+    void copy(SDL_Texture* texture, SDL_Rect const* src, SDL_Rect const& dst);
+    void glyph(SDL_Texture* atlas, SDL_Rect const& src, SDL_Rect const& dst, SDL_Color const& color);
+    
+    /**
+     * @brief   Marks the slice being recorded as volatile (e.g. because it drew something that can't be replayed)
+     */
+    void mark_volatile();
+    
+    /// accessors:
+    /**
+     * @brief   Checks whether slice `index` was recorded and can be replayed
+     */
+    bool is_recorded(std::size_t index) const;
+    bool is_volatile(std::size_t index) const;
+    
+    /**
+     * @brief   Draws the commands of slice `index` (into the active RenderBatch, if any)
+     * @pre     is_recorded(index)
+     */
+    void replay(Renderer const& renderer, std::size_t index) const;
+    
+    /// @return The number of commands held, including those of discarded slices not yet compacted
+    std::size_t size() const;
+    
+    /**
+     * @brief   The list currently recording, or nullptr
+     */
+    static DisplayList* recording();
+    
+private:
+    enum Kind : Uint8
+    {
+        FILL_RECT,
+        OUTLINE_RECT,
+        COPY,           //  src.w == 0: the whole texture
+        GLYPH_RUN,      //  `count` glyphs from one atlas follow, drawn with `color` as colour/alpha mod
+        GLYPH,
+    };
+    
+    struct Command
+    {
+        Kind kind;
+        Uint32 count;
+        SDL_Color color;
+        SDL_Texture* texture;
+        SDL_Rect src;
+        SDL_Rect dst;
+    };
+    
+    enum State : Uint8
+    {
+        EMPTY,
+        RECORDED,
+        VOLATILE,
+    };
+    
+    struct Slice
+    {
+        std::size_t offset;
+        std::size_t count;
+        State state;
+    };
+    
+    std::vector<Command> m_commands;
+    std::vector<Slice> m_slices;
+    std::size_t m_garbage;      //  commands belonging to discarded slices
+    
+    //  recording state
+    std::size_t m_current;      //  index of the slice being recorded
+    std::size_t m_run;          //  position of the current glyph run, m_commands.size() if none
+    bool m_volatile;
+    DisplayList* m_previous;    //  the list that was recording before this one
+    
+    static DisplayList* s_recording;
+    
+private:
+    /// helper functions:
+    void push(Command const& command);
+    void discard(std::size_t index);
+    
+    /**
+     * @brief   Drops the commands of discarded slices once they outnumber the live ones
+     */
+    void compact();
+};
+
+
+/// accessors:
+inline bool DisplayList::is_recorded(std::size_t index) const { return index < m_slices.size() && m_slices[index].state == RECORDED; }
+inline bool DisplayList::is_volatile(std::size_t index) const { return index < m_slices.size() && m_slices[index].state == VOLATILE; }
+inline std::size_t DisplayList::size() const { return m_commands.size(); }
+inline DisplayList* DisplayList::recording() { return s_recording; }
+
+
+#endif
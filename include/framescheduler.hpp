@@ -0,0 +1,119 @@
+/*
+ *      Copyright (C) 2020 Johnathan Law
+ *
+ *      This file is part of SWL.
+ *
+ *      SWL is free software: you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation, either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      SWL is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with SWL.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef FRAMESCHEDULER_HPP
+#define FRAMESCHEDULER_HPP
+
+#include "sdl_inc.hpp"
+
+
+/**
+ * @brief   Paces the main loop. Frames are capped at a target frame rate while
+ *          updates are run on a fixed timestep, decoupled from the frame rate.
+ *
+ * @note    Usage:
+ *              scheduler.begin_frame();
+ *              handle_events();
+ *              while (scheduler.should_update())
+ *                  update();       //  runs update_rate() times per second
+ *              render();
+ *              scheduler.end_frame();  //  sleeps for whatever is left of the frame
+ *
+ * @note    A frame rate of 0 uncaps the frame rate. An update rate of 0 runs
+ *          exactly one update per frame.
+ * @note    If a frame runs long, at most MAX_UPDATES_PER_FRAME updates are run to
+ *          catch up and the rest of the backlog is dropped, so slow frames don't compound.
+ */
+class FrameScheduler
+{
+public:
+    static constexpr unsigned MAX_UPDATES_PER_FRAME = 5;
+    
+public:
+    /// constructors:
+    FrameScheduler(unsigned frame_rate = 60, unsigned update_rate = 60) noexcept;
+    
+    /// modifiers:
+    void frame_rate(unsigned fps);
+    void update_rate(unsigned ups);
+    
+    /**
+     * @brief   With vsync on, SDL_RenderPresent() already waits for the display,
+     *          so end_frame() will not sleep.
+     */
+    void vsync(bool on);
+    
+    /**
+     * @brief   Restarts timing, e.g. after the loop was blocked waiting for events.
+     *          The next frame runs a single update instead of catching up on the time spent blocked.
+     */
+    void restart();
+    
+    /**
+     * @brief   Marks the start of a frame, adding the elapsed time to the update accumulator
+     */
+    void begin_frame();
+    
+    /**
+     * @brief   Consumes one timestep from the update accumulator
+     * @return  true if an update is due, false otherwise
+     */
+    bool should_update();
+    
+    /**
+     * @brief   Sleeps until the next frame is due (accounting for time already spent)
+     */
+    void end_frame();
+    
+    /// accessors:
+    unsigned frame_rate() const;
+    unsigned update_rate() const;
+    bool vsync() const;
+    
+    /// @return The fraction (in [0, 1[) of a timestep left in the accumulator, useful for interpolation
+    double alpha() const;
+    
+    /// @return Milliseconds left until the next frame is due (0 if it is already due or uncapped)
+    Uint32 time_to_next_frame() const;
+    
+private:
+    Uint64 m_frequency;         //  performance counter ticks per second
+    Uint64 m_frame_ticks;       //  counter ticks per frame (0: uncapped)
+    Uint64 m_update_ticks;      //  counter ticks per update (0: once per frame)
+    
+    Uint64 m_last_time;         //  counter value at the start of the previous frame
+    Uint64 m_next_frame;        //  counter value at which the next frame is due
+    Uint64 m_accumulator;       //  counter ticks not yet consumed by updates
+    unsigned m_updates;         //  updates run in the current frame
+    
+    unsigned m_frame_rate;
+    unsigned m_update_rate;
+    bool m_vsync;
+    bool m_started;
+};
+
+
+/// accessors:
+inline unsigned FrameScheduler::frame_rate() const { return m_frame_rate; }
+inline unsigned FrameScheduler::update_rate() const { return m_update_rate; }
+inline bool FrameScheduler::vsync() const { return m_vsync; }
+
+
+#endif
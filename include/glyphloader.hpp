@@ -0,0 +1,117 @@
+/*
+ *      Copyright (C) 2020 Johnathan Law
+ *
+ *      This file is part of SWL.
+ *
+ *      SWL is free software: you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation, either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      SWL is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with SWL.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GLYPHLOADER_HPP
+#define GLYPHLOADER_HPP
+
+#include "types.hpp"
+
+#include "sdl_ttf_inc.hpp"
+
+#include <list>
+#include <memory>
+#include <string>
+#include <thread>
+
+
+/**
+ * Character sets to preload fonts with, see Application::add_font()
+ */
+namespace Charset
+{
+    //  printable ASCII (U+0020-U+007E)
+    const auto ASCII = " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~";
+    
+    //  printable ASCII and the Latin-1 Supplement (U+00A0-U+00FF), in UTF-8
+    const std::string LATIN_1 = std::string(ASCII) +
+                              u8"\u00A0\u00A1\u00A2\u00A3\u00A4\u00A5\u00A6\u00A7\u00A8\u00A9\u00AA\u00AB\u00AC\u00AD\u00AE\u00AF"
+                              u8"\u00B0\u00B1\u00B2\u00B3\u00B4\u00B5\u00B6\u00B7\u00B8\u00B9\u00BA\u00BB\u00BC\u00BD\u00BE\u00BF"
+                              u8"\u00C0\u00C1\u00C2\u00C3\u00C4\u00C5\u00C6\u00C7\u00C8\u00C9\u00CA\u00CB\u00CC\u00CD\u00CE\u00CF"
+                              u8"\u00D0\u00D1\u00D2\u00D3\u00D4\u00D5\u00D6\u00D7\u00D8\u00D9\u00DA\u00DB\u00DC\u00DD\u00DE\u00DF"
+                              u8"\u00E0\u00E1\u00E2\u00E3\u00E4\u00E5\u00E6\u00E7\u00E8\u00E9\u00EA\u00EB\u00EC\u00ED\u00EE\u00EF"
+                              u8"\u00F0\u00F1\u00F2\u00F3\u00F4\u00F5\u00F6\u00F7\u00F8\u00F9\u00FA\u00FB\u00FC\u00FD\u00FE\u00FF";
+}
+
+
+/**
+ * @brief   Rasterizes the glyphs of fonts on worker threads, so that they needn't be rasterized
+ *          one by one the first time they're drawn. The rasterized glyphs are packed and uploaded
+ *          to each font's atlas by upload(), on the rendering thread.
+ *
+ * @note    Usage:
+ *              auto font = make_shared_font(renderer, filename, size, color, style, "");  //  no glyphs upfront
+ *              loader.load(font, filename, size, style, Charset::ASCII);                   //  returns immediately
+ *              ...
+ *              loader.upload();    //  before the font is first drawn with
+ *
+ * @note    Each worker rasterizes from its own TTF_Font, opened and closed on the calling thread,
+ *          so the font can be used meanwhile: glyphs it caches by itself are skipped by upload().
+ */
+class GlyphLoader
+{
+public:
+    /// constructors:
+    GlyphLoader() = default;
+    GlyphLoader(GlyphLoader const&) = delete;
+    GlyphLoader& operator= (GlyphLoader const&) = delete;
+    
+    /// destructor:
+    /**
+     * @brief   Waits for the workers, discarding the glyphs which weren't uploaded
+     */
+    ~GlyphLoader();
+    
+    /// modifiers:
+    /**
+     * @brief   Starts rasterizing `charset` (UTF-8) for `font` on a worker thread
+     * @param   filename, point_size, style What `font` was loaded with
+     * @return  false if the font file couldn't be opened
+     */
+    bool load(SharedFont const& font, std::string const& filename, Uint32 point_size, int style,
+              std::string const& charset);
+    
+    /**
+     * @brief   Waits for the workers, then adds the rasterized glyphs to their fonts. Each atlas
+     *          level touched is uploaded once. Does nothing if nothing is pending.
+     */
+    void upload();
+    
+    /// accessors:
+    bool pending() const;
+    
+private:
+    struct Job
+    {
+        FontRef font;
+        TTFont ttf;                 //  the worker's own copy of the font
+        std::string charset;
+        FC_GlyphSet* glyphs;        //  written by the worker, read after joining it
+        std::thread worker;
+    };
+    
+    std::list<std::unique_ptr<Job>> m_jobs;
+};
+
+
+/// accessors:
+inline bool GlyphLoader::pending() const { return !m_jobs.empty(); }
+
+
+#endif
@@ -0,0 +1,140 @@
+/*
+ *      Copyright (C) 2020 Johnathan Law
+ *
+ *      This file is part of SWL.
+ *
+ *      SWL is free software: you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation, either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      SWL is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with SWL.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef INPUTRECORDER_HPP
+#define INPUTRECORDER_HPP
+
+#include "sdl_inc.hpp"
+
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief   Records input events, grouped by frame, to a compact binary file and loads them back
+ *          for replay (see Application::record_input() and Application::replay()).
+ *
+ * @note    Usage:
+ *              recorder.start("session.swlr");
+ *              //  for every frame:
+ *              recorder.record(event);     //  for each event received from SDL
+ *              recorder.end_frame(updates);
+ *              recorder.stop();
+ *
+ *              auto frames = InputRecorder::load("session.swlr");
+ *
+ * @note    Only mouse, wheel, keyboard, window and quit events are recorded. Each record is
+ *          timestamped in milliseconds since the start of the recording. Consecutive frames without
+ *          events which ran loop() equally often are written as a single frame marker with a repeat
+ *          count, so idle stretches take a few bytes instead of a few bytes per frame. Replaying
+ *          still runs each of those frames (loop() and render()) on its own.
+ */
+class InputRecorder
+{
+public:
+    struct Frame
+    {
+        Uint32 time;                    //  milliseconds since the start of the recording (at the end of the last repeat)
+        unsigned updates;               //  number of times loop() ran during the frame
+        unsigned repeat;                //  number of consecutive identical frames this stands for (1 if it has events)
+        std::vector<SDL_Event> events;  //  events received during the frame, in order
+    };
+    
+public:
+    /// constructors:
+    InputRecorder() noexcept;
+    InputRecorder(InputRecorder const&) = delete;
+    
+    /// destructor:
+    ~InputRecorder();
+    
+    /// modifiers:
+    /**
+     * @brief   Starts recording to `filename`, overwriting it
+     * @return  false if the file couldn't be opened
+     */
+    bool start(std::string const& filename);
+    
+    /**
+     * @brief   Flushes and closes the file. Called by the destructor.
+     */
+    void stop();
+    
+    /**
+     * @brief   Records an event of the current frame. Does nothing if not recording or if
+     *          the event type isn't recorded.
+     */
+    void record(SDL_Event const& event);
+    
+    /**
+     * @brief   Ends the current frame, during which loop() was called `updates` times
+     */
+    void end_frame(unsigned updates);
+    
+    /// accessors:
+    bool is_recording() const;
+    
+    /**
+     * @brief   Loads a recording
+     * @throws  std::runtime_error if the file can't be read or isn't a recording
+     */
+    static std::vector<Frame> load(std::string const& filename);
+    
+private:
+    std::ofstream m_file;
+    Uint32 m_start;             //  ticks at the start of the recording
+    unsigned m_frame_events;    //  events recorded in the current frame
+    unsigned m_idle_updates;    //  updates per frame of the event-less frames not yet written
+    unsigned m_idle_frames;     //  number of event-less frames not yet written
+    Uint32 m_idle_time;         //  end of the last event-less frame
+    
+private:
+    /// helper functions:
+    void write_frame(Uint32 time, unsigned updates, unsigned repeat = 1);
+    void write_idle_frames();
+    Uint32 elapsed() const;
+};
+
+
+/**
+ * @brief   Timings of a replayed recording (see Application::replay())
+ */
+struct ReplayStats
+{
+    unsigned frames = 0;
+    unsigned events = 0;
+    unsigned redraws = 0;       //  frames in which something was repainted
+    double total_ms = 0;
+    double frame_median_ms = 0;
+    double frame_p90_ms = 0;
+    double frame_p99_ms = 0;
+    double frame_max_ms = 0;
+};
+
+std::ostream& operator<< (std::ostream& os, ReplayStats const& stats);
+
+
+/// accessors:
+inline bool InputRecorder::is_recording() const { return m_file.is_open(); }
+
+
+#endif
@@ -31,6 +31,9 @@
  *          The user can set handlers through the on_event functions.
  *          This interface allows you to override behaviour when
  *
+ * @note    Widgets implementing this interface should forward
+ *          WidgetItem::handle_mouse_enter()/handle_mouse_leave() to entered()/left().
+ *
  */
 class ButtonInterface
 {
@@ -47,6 +50,8 @@ public:
     void on_right_clicked(MouseEventCallback);
     void on_pressed(MouseEventCallback);
     void on_hovered(MouseEventCallback);
+    void on_enter(MouseEventCallback);
+    void on_leave(MouseEventCallback);
     
 protected:
     virtual void clicked(MouseEvent const&) const;
@@ -54,6 +59,8 @@ protected:
     virtual void right_clicked(MouseEvent const&) const;
     virtual void pressed(MouseEvent const&) const;
     virtual void hovered(MouseEvent const&) const;
+    virtual void entered(MouseEvent const&) const;
+    virtual void left(MouseEvent const&) const;
     
     void handle(MouseEvent const& event) const;
     
@@ -63,6 +70,8 @@ private:
     MouseEventCallback m_right_clicked;
     MouseEventCallback m_pressed;
     MouseEventCallback m_hovered;
+    MouseEventCallback m_entered;
+    MouseEventCallback m_left;
 
 };
 
@@ -76,12 +85,16 @@ inline void ButtonInterface::on_left_clicked(MouseEventCallback f) { m_left_clic
 inline void ButtonInterface::on_right_clicked(MouseEventCallback f) { m_right_clicked = f; }
 inline void ButtonInterface::on_pressed(MouseEventCallback f) { m_pressed = f; }
 inline void ButtonInterface::on_hovered(MouseEventCallback f) { m_hovered = f; }
+inline void ButtonInterface::on_enter(MouseEventCallback f) { m_entered = f; }
+inline void ButtonInterface::on_leave(MouseEventCallback f) { m_left = f; }
 
 inline void ButtonInterface::clicked(MouseEvent const& event) const { if (m_clicked) m_clicked(event); }
 inline void ButtonInterface::left_clicked(MouseEvent const& event) const { if (m_left_clicked) m_left_clicked(event); }
 inline void ButtonInterface::right_clicked(MouseEvent const& event) const { if (m_right_clicked) m_right_clicked(event); }
 inline void ButtonInterface::pressed(MouseEvent const& event) const { if (m_pressed) m_pressed(event); }
 inline void ButtonInterface::hovered(MouseEvent const& event) const { if (m_hovered) m_hovered(event); }
+inline void ButtonInterface::entered(MouseEvent const& event) const { if (m_entered) m_entered(event); }
+inline void ButtonInterface::left(MouseEvent const& event) const { if (m_left) m_left(event); }
 
 
 
@@ -22,6 +22,7 @@
 #ifndef INTERFACE_TEXT_HPP
 #define INTERFACE_TEXT_HPP
 
+#include "textlayout.hpp"
 #include "types.hpp"
 #include "utility.hpp"
 #include <string>
@@ -29,6 +30,13 @@
 
 /**
  * @brief   A generic interface for text
+ *
+ * @note    Changing the text, font or alignment calls text_changed(). Widgets
+ *          override it to invalidate themselves.
+ *
+ * @note    The text is laid out once and drawn from the cached TextLayout (see render_text())
+ *          until the text, font, alignment or bounds change. Subclasses overriding text()
+ *          must call m_layout.invalidate() when the text it returns changes.
  */
 class TextInterface
 {
@@ -56,10 +64,22 @@ public:
     static void default_font(FontRef const& font);
     static FontRef const& default_font();
     
+protected:
+    /**
+     * @brief   Called after the text, font or alignment changes
+     */
+    virtual void text_changed();
+    
+    /**
+     * @brief   Draws the text within `bounds`, laying it out first if needed
+     */
+    void render_text(Renderer const&, SDL_Rect const& bounds) const;
+    
 protected:
     std::string m_text;
     FontRef m_font;
     Alignment m_alignment;
+    mutable TextLayout m_layout;
     
 private:
     static FontRef m_default_font;
@@ -80,16 +100,26 @@ inline TextInterface::TextInterface(std::string const& text, FontRef const& font
 inline TextInterface::~TextInterface() = default;
 
 /// modifiers:
-inline void TextInterface::text(std::string const& text) { m_text = text; }
+inline void TextInterface::text(std::string const& text) { if (m_text != text) { m_text = text; m_layout.invalidate(); text_changed(); } }
 inline void TextInterface::text(std::string const& text_, Alignment alignment) { text(text_); align(alignment); }
 inline void TextInterface::text(std::string const& text_, FontRef const& font_) { text(text_); font(font_); }
 inline void TextInterface::text(std::string const& text_, FontRef const& font_, Alignment alignment) { text(text_, font_); align(alignment); }
-inline void TextInterface::font(FontRef const& font) { if (!font.expired()) m_font = font; }
-inline void TextInterface::align(Alignment alignment) { m_alignment = alignment; }
+inline void TextInterface::font(FontRef const& font) { if (!font.expired()) { m_font = font; m_layout.invalidate(); text_changed(); } }
+inline void TextInterface::align(Alignment alignment) { if (m_alignment != alignment) { m_alignment = alignment; m_layout.invalidate(); text_changed(); } }
 
 /// accessors:
 inline std::string const& TextInterface::text() const { return m_text; }
 
+/// protected:
+inline void TextInterface::text_changed() {}
+
+inline void TextInterface::render_text(Renderer const& renderer, SDL_Rect const& bounds) const
+{
+    const auto font = m_font.lock();
+    m_layout.update(font, text(), bounds, m_alignment);
+    m_layout.render(renderer, font);
+}
+
 /// static methods:
 inline void TextInterface::default_font(FontRef const& font) { if (!font.expired()) m_default_font = font; }
 inline FontRef const& TextInterface::default_font() { return m_default_font; }
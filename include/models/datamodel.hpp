@@ -21,22 +21,94 @@
 #ifndef DATAMODEL_HPP
 #define DATAMODEL_HPP
 
+#include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 
 
 /**
  * @brief   A base class for MVC models.
  *          Model: knows nothing about visualisation and user interaction,
  *                 only about the data / structure.
+ *
+ * @note    Views are notified of changes through listeners (see on_changed()).
+ *          Derived models should call changed() after every mutation.
  */
 template<class T>
 class DataModel
 {
 public:
+    using Listener = std::function<void()>;
+    using ListenerHandle = std::shared_ptr<Listener>;
+    
+public:
+    /// constructors:
+    DataModel() noexcept = default;
+    DataModel(DataModel const&) noexcept;   //  listeners are not copied
+    
+    /// destructor:
+    virtual ~DataModel() = default;
+    
+    /// assignment:
+    DataModel& operator= (DataModel const&) noexcept;
+    
+    /// modifiers:
+    /**
+     * @brief   Registers a listener, called whenever the model changes.
+     *          The listener stays registered for as long as the returned handle is alive,
+     *          so neither the model nor the listener needs to outlive the other.
+     */
+    ListenerHandle on_changed(Listener) const;
+    
+    /**
+     * @brief   Notifies listeners that the model changed.
+     *          Call this after modifying items in place (e.g. through a non-const accessor).
+     */
+    void changed() const;
+    
     /// accessors:
     virtual std::size_t rows() const = 0;
     virtual T const& at(std::size_t index) const = 0;
+    
+private:
+    mutable std::vector<std::weak_ptr<Listener>> m_listeners;
 };
 
 
+/// constructors:
+template<class T>
+inline DataModel<T>::DataModel(DataModel const&) noexcept {}
+
+/// assignment:
+template<class T>
+inline DataModel<T>& DataModel<T>::operator= (DataModel const&) noexcept { return *this; }
+
+/// modifiers:
+template<class T>
+typename DataModel<T>::ListenerHandle DataModel<T>::on_changed(Listener listener) const
+{
+    auto handle = std::make_shared<Listener>(std::move(listener));
+    m_listeners.push_back(handle);
+    return handle;
+}
+
+template<class T>
+void DataModel<T>::changed() const
+{
+    for (auto it = m_listeners.begin(); it != m_listeners.end();)
+    {
+        if (auto listener = it->lock())
+        {
+            (*listener)();
+            ++it;
+        }
+        else
+        {
+            it = m_listeners.erase(it);  //  the listener's owner is gone
+        }
+    }
+}
+
+
 #endif
@@ -56,6 +56,8 @@ public:
  *
  * @note    Use in conjunction with ListView.
  * @note    Items should inherit ListItem.
+ * @note    Modifiers notify listeners (e.g. views) through changed(). Modifying items
+ *          through the non-const accessors does not; call changed() afterwards.
  */
 template<class T, typename = typename std::enable_if<std::is_base_of<ListItem, T>::value>::type>
 class ListModel;
@@ -129,7 +131,7 @@ private:
 
 /// modifiers:
 template<class T>
-inline ListModel<T>& ListModel<T>::add(T const& item) { add_if_can_sort(item); return *this; }
+inline ListModel<T>& ListModel<T>::add(T const& item) { add_if_can_sort(item); this->changed(); return *this; }
 
 template<class T>
 ListModel<T>& ListModel<T>::add_items(std::vector<T> const& items)
@@ -137,6 +139,8 @@ ListModel<T>& ListModel<T>::add_items(std::vector<T> const& items)
     m_items.reserve(m_items.size() + items.size());
     for (auto const& item : items)
         add_if_can_sort(item);
+    if (!items.empty())
+        this->changed();
     return *this;
 }
 
@@ -144,7 +148,10 @@ template<class T>
 ListModel<T>& ListModel<T>::remove(std::size_t index)
 {
     if (index < m_items.size())
+    {
         m_items.erase(m_items.begin() + index);
+        this->changed();
+    }
     return *this;
 }
 
@@ -158,6 +165,8 @@ ListModel<T>& ListModel<T>::remove_selected_items()
             m_items.erase(m_items.begin() + i - correction);
             correction++;
         }
+    if (correction)
+        this->changed();
     return *this;
 }
 
@@ -165,6 +174,7 @@ template<class T>
 inline ListModel<T>& ListModel<T>::clear()
 {
     m_items.clear();
+    this->changed();
     return *this;
 }
 
@@ -177,27 +187,34 @@ ListModel<T>& ListModel<T>::sorter(Comparator cmp)
 }
 
 template<class T>
-inline void ListModel<T>::select(std::size_t index) { m_items.at(index).selected = true; }
+inline void ListModel<T>::select(std::size_t index) { m_items.at(index).selected = true; this->changed(); }
 template<class T>
-inline void ListModel<T>::unselect(std::size_t index) { m_items.at(index).selected = false; }
+inline void ListModel<T>::unselect(std::size_t index) { m_items.at(index).selected = false; this->changed(); }
 template<class T>
 inline void ListModel<T>::toggle_select(std::size_t index)
 {
     if (0 <= index && index < m_items.size())
+    {
         m_items[index].selected = !m_items[index].selected;
+        this->changed();
+    }
 }
 
 template<class T>
 inline void ListModel<T>::sort_once(Comparator cmp)
 {
     if (cmp || m_cmp)
+    {
         std::sort(m_items.begin(), m_items.end(), cmp ? cmp : m_cmp);
+        this->changed();
+    }
 }
 
 template<class T>
 inline void ListModel<T>::partition_once(Partitioner cmp)
 {
     std::stable_partition(m_items.begin(), m_items.end(), cmp);
+    this->changed();
 }
 
 /// accessors:
@@ -0,0 +1,146 @@
+/*
+ *      Copyright (C) 2020 Johnathan Law
+ *
+ *      This file is part of SWL.
+ *
+ *      SWL is free software: you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation, either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      SWL is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with SWL.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RENDERBATCH_HPP
+#define RENDERBATCH_HPP
+
+#include "renderstate.hpp"
+#include "types.hpp"
+
+#include "sdl_inc.hpp"
+
+#include <vector>
+
+
+/**
+ * @brief   Collects consecutive primitives that share renderer state and submits them in
+ *          as few SDL calls as possible: rect fills and outlines of one colour go through
+ *          SDL_RenderFillRects()/SDL_RenderDrawRects(), textured quads (e.g. glyphs) from one
+ *          texture go through a single SDL_RenderGeometry() call. Pending primitives are
+ *          flushed as soon as a primitive of another kind, colour or texture is added, so
+ *          drawing order is preserved.
+ *
+ * @note    While a batch is active (between construction and destruction), the render utility
+ *          functions (draw_rect(), draw_filled_rect(), render_texture(), and text drawn through
+ *          FontCache) queue into it instead of drawing immediately. Code that changes renderer
+ *          state or draws through SDL directly must call flush() first.
+ *
+ * @note    Usage:
+ *              {
+ *                  RenderBatch batch{renderer};
+ *                  draw_filled_rect(...);
+ *                  draw_text(...);
+ *              }   //  flushed
+ *
+ * @note    SDL_RenderGeometry() requires SDL 2.0.18. With older versions, quads are drawn
+ *          one SDL_RenderCopy() at a time (fills and outlines are still batched).
+ */
+class RenderBatch
+{
+public:
+    /// constructors:
+    explicit RenderBatch(Renderer const& renderer);
+    RenderBatch(RenderBatch const&) = delete;
+    
+    /// destructor:
+    /**
+     * @brief   Flushes, and reactivates the batch that was active before this one, if any
+     */
+    ~RenderBatch();
+    
+    /// assignment:
+    RenderBatch& operator= (RenderBatch const&) = delete;
+    
+    /// modifiers:
+    void fill_rect(SDL_Rect const& rect, SDL_Color const& color);
+    void outline_rect(SDL_Rect const& rect, SDL_Color const& color);
+    
+    /**
+     * @brief   Queues a copy of (a part of) a texture
+     * @param   src The part of the texture to copy, or nullptr for the whole texture
+     * @param   color The colour (and alpha) to modulate the texture with, instead of the texture's
+     *          own colour/alpha mod (which the first overload uses)
+     */
+    void copy(SDL_Texture* texture, SDL_Rect const* src, SDL_Rect const& dst);
+    void copy(SDL_Texture* texture, SDL_Rect const* src, SDL_Rect const& dst, SDL_Color const& color);
+    
+    /**
+     * @brief   Submits pending primitives
+     */
+    void flush();
+    
+    /// accessors:
+    /**
+     * @brief   The innermost active batch, or nullptr
+     */
+    static RenderBatch* active();
+    
+private:
+    enum Kind
+    {
+        NONE,
+        FILL_RECTS,
+        OUTLINE_RECTS,
+        QUADS,
+    };
+    
+    struct Quad
+    {
+        SDL_Rect src;
+        SDL_Rect dst;
+        SDL_Color color;
+    };
+    
+    SDL_Renderer* m_renderer;
+    RenderState& m_state;
+    RenderBatch* m_previous;
+    
+    Kind m_kind;
+    SDL_Color m_color;          //  of pending rects
+    SDL_Texture* m_texture;     //  of pending quads
+    int m_texture_w;
+    int m_texture_h;
+    
+    std::vector<SDL_Rect> m_rects;
+    std::vector<Quad> m_quads;
+    
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    std::vector<SDL_Vertex> m_vertices;
+    std::vector<int> m_indices;
+#endif
+    
+    static RenderBatch* s_active;
+    
+private:
+    /// helper functions:
+    /**
+     * @brief   Flushes unless pending primitives are of the given kind and state
+     */
+    void prepare(Kind kind, SDL_Color const& color, SDL_Texture* texture);
+    
+    void flush_quads();
+};
+
+
+/// accessors:
+inline RenderBatch* RenderBatch::active() { return s_active; }
+
+
+#endif
@@ -0,0 +1,179 @@
+/*
+ *      Copyright (C) 2020 Johnathan Law
+ *
+ *      This file is part of SWL.
+ *
+ *      SWL is free software: you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation, either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      SWL is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with SWL.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RENDERSTATE_HPP
+#define RENDERSTATE_HPP
+
+#include "sdl_inc.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+
+/**
+ * @brief   Remembers the state last set on a renderer (draw colour, blend mode, target,
+ *          clip rect, and the colour/alpha mods of its textures), and skips SDL calls that
+ *          wouldn't change it.
+ *
+ * @note    Usage:
+ *              auto& state = RenderState::of(renderer);
+ *              state.draw_color(color);    //  only calls SDL_SetRenderDrawColor() if `color` changed
+ *              SDL_RenderFillRect(...);
+ *
+ * @note    State is unknown until first set, so the first call always goes through. Code that
+ *          changes renderer state by calling SDL directly (without restoring it) must call
+ *          invalidate() afterwards, or later calls may be wrongly skipped.
+ *
+ * @note    Render contexts (see push_context()) let nested drawing happen relative to, and
+ *          clipped to, an area of the target, without a texture of its own.
+ *
+ * @note    States are created on demand, one per renderer, and dropped with forget(), which
+ *          the deleters of Renderer and Texture (see make_renderer(), make_texture()) call.
+ */
+class RenderState
+{
+public:
+    /// constructors:
+    RenderState(SDL_Renderer* renderer) noexcept;
+    RenderState(RenderState const&) = delete;
+    
+    /// modifiers:
+    void draw_color(SDL_Color const& color);
+    void blend_mode(SDL_BlendMode mode);
+    
+    /**
+     * @brief   Sets the render target (nullptr for the default target).
+     * @note    SDL resets the viewport and clip rect when switching targets, so they become unknown.
+     */
+    void target(SDL_Texture* texture);
+    
+    /**
+     * @brief   Sets the clip rect, or disables clipping if `rect` is nullptr
+     */
+    void clip(SDL_Rect const* rect);
+    
+    /**
+     * @brief   Sets the viewport (relative to the target), or resets it to the whole target
+     *          if `rect` is nullptr. Drawing and the clip rect are relative to the viewport.
+     */
+    void viewport(SDL_Rect const* rect);
+    
+    /**
+     * @brief   Enters a render context: drawing becomes relative to `area` (given relative to the
+     *          current viewport) and is clipped to the part of it that is visible in the current context.
+     *          Each call must be matched by a call to pop_context(), which restores the previous context.
+     * @return  false if none of `area` is visible, in which case the renderer is left untouched
+     */
+    bool push_context(SDL_Rect const& area);
+    void pop_context();
+    
+    void texture_color_mod(SDL_Texture* texture, Uint8 r, Uint8 g, Uint8 b);
+    void texture_alpha_mod(SDL_Texture* texture, Uint8 a);
+    
+    /**
+     * @brief   Forgets all state, e.g. after calling SDL directly
+     */
+    void invalidate();
+    
+    void reset_counters();
+    
+    /// accessors:
+    /**
+     * @brief   The current render target. Only queries SDL if unknown.
+     */
+    SDL_Texture* target();
+    
+    /**
+     * @brief   The current clip rect, empty if clipping is disabled. Only queries SDL if unknown.
+     */
+    SDL_Rect clip();
+    
+    /**
+     * @brief   The current viewport. Only queries SDL if unknown.
+     */
+    SDL_Rect viewport();
+    
+    /// @return The number of state changes passed on to SDL
+    unsigned long issued() const;
+    
+    /// @return The number of state changes skipped because they wouldn't have changed anything
+    unsigned long saved() const;
+    
+    /**
+     * @brief   The state of a renderer, created if needed
+     */
+    static RenderState& of(SDL_Renderer* renderer);
+    
+    /**
+     * @brief   Drops the state of a renderer, or the mods remembered for a texture
+     *          (call before destroying them)
+     */
+    static void forget(SDL_Renderer* renderer);
+    static void forget(SDL_Texture* texture);
+    
+private:
+    struct TextureMods
+    {
+        SDL_Color mod;
+        bool color_known;
+        bool alpha_known;
+    };
+    
+    struct Context
+    {
+        SDL_Rect viewport;
+        SDL_Rect clip;
+    };
+    
+    SDL_Renderer* m_renderer;
+    
+    SDL_Color m_draw_color;
+    SDL_BlendMode m_blend_mode;
+    SDL_Texture* m_target;
+    SDL_Rect m_clip;            //  empty: clipping disabled
+    SDL_Rect m_viewport;
+    std::unordered_map<SDL_Texture*, TextureMods> m_textures;
+    std::vector<Context> m_contexts;    //  contexts to restore, innermost last
+    
+    bool m_draw_color_known;
+    bool m_blend_mode_known;
+    bool m_target_known;
+    bool m_clip_known;
+    bool m_viewport_known;
+    
+    unsigned long m_issued;
+    unsigned long m_saved;
+    
+private:
+    /// helper functions:
+    /**
+     * @brief   Counts the call as saved if `unchanged`, otherwise as issued
+     * @return  true if the call should be issued
+     */
+    bool needed(bool unchanged);
+};
+
+
+/// accessors:
+inline unsigned long RenderState::issued() const { return m_issued; }
+inline unsigned long RenderState::saved() const { return m_saved; }
+
+
+#endif
@@ -0,0 +1,115 @@
+/*
+ *      Copyright (C) 2020 Johnathan Law
+ *
+ *      This file is part of SWL.
+ *
+ *      SWL is free software: you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation, either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      SWL is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with SWL.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SPATIALGRID_HPP
+#define SPATIALGRID_HPP
+
+#include "types.hpp"
+#include "sdl_inc.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+
+/**
+ * @brief   A uniform grid over item rects, for finding the items under a point
+ *          without testing every item.
+ *
+ * @note    Each item is registered in every cell its rect touches. The right and
+ *          bottom edges are inclusive, to agree with WidgetItem::is_point_inside().
+ * @note    Ids within a cell are kept sorted, so query() reports them in insertion
+ *          (z-)order. Only cells that contain items take up memory.
+ */
+class SpatialGrid
+{
+public:
+    static constexpr int DEFAULT_CELL_SIZE = 64;
+    
+public:
+    /// constructors:
+    SpatialGrid(int cell_size = DEFAULT_CELL_SIZE) noexcept;
+    
+    /// modifiers:
+    void insert(ItemID id, SDL_Rect const& rect);
+    void remove(ItemID id, SDL_Rect const& rect);
+    
+    /**
+     * @brief   Re-registers an item which moved or was resized.
+     *          Only the cells that differ between the two rects are touched.
+     */
+    void move(ItemID id, SDL_Rect const& from, SDL_Rect const& to);
+    
+    void clear();
+    
+    /// accessors:
+    int cell_size() const;
+    
+    /**
+     * @brief   Appends the ids of items whose rects might contain (x, y) to `out`.
+     *          Callers should still test the point against each item.
+     */
+    void query(int x, int y, std::vector<ItemID>& out) const;
+    
+private:
+    using CellKey = std::uint64_t;
+    
+    struct CellRange
+    {
+        int x0, y0, x1, y1;     //  inclusive
+        bool contains(int cx, int cy) const;
+    };
+    
+    int m_cell_size;
+    std::unordered_map<CellKey, std::vector<ItemID>> m_cells;
+    
+private:
+    /// helper functions:
+    int cell_of(int coord) const;
+    CellRange cells_of(SDL_Rect const& rect) const;
+    static CellKey key(int cx, int cy);
+    
+    void insert_into(CellKey, ItemID);
+    void remove_from(CellKey, ItemID);
+};
+
+
+/// accessors:
+inline int SpatialGrid::cell_size() const { return m_cell_size; }
+
+/// helper functions:
+inline bool SpatialGrid::CellRange::contains(int cx, int cy) const
+{
+    return x0 <= cx && cx <= x1 && y0 <= cy && cy <= y1;
+}
+
+inline int SpatialGrid::cell_of(int coord) const
+{
+    //  round towards negative infinity, so that negative coordinates map to their own cells
+    return coord >= 0 ? coord / m_cell_size : -((-coord - 1) / m_cell_size) - 1;
+}
+
+inline SpatialGrid::CellKey SpatialGrid::key(int cx, int cy)
+{
+    return (CellKey(std::uint32_t(cx)) << 32) | std::uint32_t(cy);
+}
+
+
+#endif
@@ -0,0 +1,106 @@
+/*
+ *      Copyright (C) 2020 Johnathan Law
+ *
+ *      This file is part of SWL.
+ *
+ *      SWL is free software: you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation, either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      SWL is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with SWL.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef TEXTLAYOUT_HPP
+#define TEXTLAYOUT_HPP
+
+#include "types.hpp"
+#include "utility.hpp"
+
+#include "sdl_inc.hpp"
+
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief   The measured and positioned glyphs of a piece of text, aligned within some bounds.
+ *          Laying out is the expensive part of drawing text (formatting, decoding and measuring
+ *          the string, looking up each glyph), so the result is kept and reused by render()
+ *          until the layout is invalidated.
+ *
+ * @note    Usage:
+ *              layout.update(font, text, bounds, alignment);   //  only lays out if something changed
+ *              layout.render(renderer, font);
+ *
+ * @note    update() notices changes to the font, bounds, alignment and the font's spacing by
+ *          itself; call invalidate() when the text changes. The font colour is read on each render().
+ *
+ * @note    Text is taken verbatim, as with FC_DrawText(): '%' is not treated as a format specifier.
+ */
+class TextLayout
+{
+public:
+    /// constructors:
+    TextLayout() noexcept;
+    
+    /// modifiers:
+    /**
+     * @brief   Lays out `text` within `bounds`, unless the current layout is still valid for them
+     */
+    void update(SharedFont const& font, std::string const& text, SDL_Rect const& bounds, Alignment alignment);
+    
+    /**
+     * @brief   Lays the text out again on the next update()
+     */
+    void invalidate();
+    
+    /// accessors:
+    bool is_valid() const;
+    
+    /**
+     * @brief   The area taken up by the text: the aligned origin, and the measured width and height
+     */
+    SDL_Rect extents() const;
+    
+    /// GUI functions:
+    /**
+     * @brief   Draws the laid out glyphs in the font's colour. Does nothing if `font` isn't the
+     *          font the text was laid out with.
+     */
+    void render(Renderer const& renderer, SharedFont const& font) const;
+    
+private:
+    //  the glyphs, spaces excluded, as parallel arrays so that runs can be drawn straight from them
+    std::vector<int> m_levels;      //  glyph cache level (atlas) of the font
+    std::vector<SDL_Rect> m_src;    //  within the atlas
+    std::vector<SDL_Rect> m_dst;
+    SDL_Rect m_extents;
+    bool m_valid;
+    
+    //  what the layout was made for
+    FC_Font* m_font;
+    SDL_Rect m_bounds;
+    Alignment m_alignment;
+    int m_line_spacing;
+    int m_letter_spacing;
+    
+private:
+    /// helper functions:
+    void clear();
+};
+
+
+/// accessors:
+inline bool TextLayout::is_valid() const { return m_valid; }
+inline SDL_Rect TextLayout::extents() const { return m_extents; }
+
+
+#endif
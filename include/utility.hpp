@@ -21,6 +21,9 @@
 #ifndef UTILITY_HPP
 #define UTILITY_HPP
 
+#include "displaylist.hpp"
+#include "renderbatch.hpp"
+#include "renderstate.hpp"
 #include "types.hpp"
 
 #include "sdl_image_inc.hpp"
@@ -59,16 +62,23 @@ TTFont make_font(TTF_Font* font);
 
 //  SDL-like initialisers
 Surface make_surface(TTFont const& font, std::string const& text, SDL_Color const& color);
+Surface make_surface(int w, int h, Uint32 format);
 Texture make_texture(Renderer const& renderer, Uint32 format, int access, int w, int h);
 Texture make_texture_from_surface(Renderer const& renderer, Surface const& surface);
 Renderer make_renderer(Window const& window, int index, Uint32 flags);
+Renderer make_software_renderer(Surface const& target);
 Window make_window(std::string const& title, int x, int y, int width, int height, Uint32 flags);
 TTFont make_font(std::string const& filename, unsigned font_size);
+/**
+ * @param   loading_string The glyphs to load upfront (see FC_SetLoadingString()), nullptr for FontCache's default (ASCII)
+ */
 SharedFont make_shared_font(Renderer const& renderer, std::string const& filename, Uint32 point_size,
-                            SDL_Color const& color, int style = TTF_STYLE_NORMAL);
+                            SDL_Color const& color, int style = TTF_STYLE_NORMAL, const char* loading_string = nullptr);
 SharedMusic make_shared_music(std::string const& source);
 
 //  render utility functions
+//  (drawing done through these is recorded by the DisplayList recording, if any,
+//   and queued into the active RenderBatch, if any)
 void set_render_color(Renderer const& renderer, SDL_Color const& color);
 void reset_target(Renderer const& renderer);
 void render_surface(Renderer const& renderer, Surface const& surface, int x, int y);
@@ -76,6 +86,21 @@ void render_surface(Renderer const& renderer, Surface const& surface, int x, int
 void render_texture(Renderer const& renderer, Texture const& texture, SDL_Rect const& bounds);
 void render_texture(Renderer const& renderer, Texture const& texture, int x, int y);
 void render_texture(Renderer const& renderer, Texture const& texture, int x, int y, int w, int h);
+void draw_surface(Renderer const& renderer, Surface const& surface, SDL_Rect const& dest);
+
+/**
+ * @brief   FontCache geometry callback (installed by make_shared_font()): draws a run of glyphs from one
+ *          atlas in a single call, or queues them into the active RenderBatch, and records them into the
+ *          recording DisplayList
+ */
+void render_glyph_run(FC_Image* atlas, FC_Target* dest, const FC_Rect* src, const FC_Rect* dst, int count, SDL_Color color);
+
+/**
+ * @brief   FontCache render callback (installed by make_shared_font()) for glyphs which aren't drawn in runs,
+ *          i.e. flipped text: draws the glyph after whatever the active RenderBatch queued, and marks the
+ *          recording DisplayList slice as volatile
+ */
+FC_Rect render_glyph(FC_Image* src, FC_Rect* srcrect, FC_Target* dest, float x, float y, float xscale, float yscale);
 
 //  text utility functions
 void draw_simple_text(Renderer const& renderer, int x, int y, SharedFont const& font, std::string const& text);
@@ -131,8 +156,14 @@ namespace Util
 //  wrapper initialisers
 static void do_nothing(TTF_Font*) {}
 inline Surface make_surface(SDL_Surface* surface) { return Surface(surface, SDL_FreeSurface); }
-inline Texture make_texture(SDL_Texture* texture) { return Texture(texture, SDL_DestroyTexture); }
-inline Renderer make_renderer(SDL_Renderer* renderer) { return Renderer(renderer, SDL_DestroyRenderer); }
+inline Texture make_texture(SDL_Texture* texture)
+{
+    return Texture(texture, [](SDL_Texture* texture) { RenderState::forget(texture); SDL_DestroyTexture(texture); });
+}
+inline Renderer make_renderer(SDL_Renderer* renderer)
+{
+    return Renderer(renderer, [](SDL_Renderer* renderer) { RenderState::forget(renderer); SDL_DestroyRenderer(renderer); });
+}
 inline Window make_window(SDL_Window* window) { return Window(window, SDL_DestroyWindow); }
 inline TTFont make_font(TTF_Font* font) { return TTFont(font, do_nothing); }
 
@@ -142,6 +173,11 @@ inline Surface make_surface(TTFont const& font, std::string const& text, SDL_Col
     return make_surface(TTF_RenderText_Solid(font.get(), text.data(), color));
 }
 
+inline Surface make_surface(int w, int h, Uint32 format)
+{
+    return make_surface(SDL_CreateRGBSurfaceWithFormat(0, w, h, SDL_BITSPERPIXEL(format), format));
+}
+
 inline Texture make_texture(Renderer const& renderer, Uint32 format, int access, int w, int h)
 {
     return make_texture(SDL_CreateTexture(renderer.get(), format, access, w, h));
@@ -157,6 +193,11 @@ inline Renderer make_renderer(Window const& window, int index, Uint32 flags)
     return make_renderer(SDL_CreateRenderer(window.get(), index, flags));
 }
 
+inline Renderer make_software_renderer(Surface const& target)
+{
+    return make_renderer(SDL_CreateSoftwareRenderer(target.get()));
+}
+
 inline Window make_window(std::string const& title, int x, int y, int width, int height, Uint32 flags)
 {
     return make_window(SDL_CreateWindow(title.data(), x, y, width, height, flags));
@@ -168,9 +209,14 @@ inline TTFont make_font(std::string const& filename, unsigned font_size)
 }
 
 inline SharedFont make_shared_font(Renderer const& renderer, std::string const& filename, Uint32 point_size,
-                                   SDL_Color const& color, int style)
+                                   SDL_Color const& color, int style, const char* loading_string)
 {
+    FC_SetGeometryCallback(&render_glyph_run);
+    FC_SetRenderCallback(&render_glyph);
+    
     auto font = std::shared_ptr<FC_Font>(FC_CreateFont(), FC_FreeFont);
+    if (loading_string)
+        FC_SetLoadingString(font.get(), loading_string);
     FC_LoadFont(font.get(), renderer.get(), filename.data(), point_size, color, style);
     return font;
 }
@@ -183,12 +229,12 @@ inline SharedMusic make_shared_music(std::string const& source)
 //  render utility functions
 inline void set_render_color(Renderer const& renderer, SDL_Color const& color)
 {
-    SDL_SetRenderDrawColor(renderer.get(), color.r, color.g, color.b, color.a);
+    RenderState::of(renderer.get()).draw_color(color);
 }
 
 inline void reset_target(Renderer const& renderer)
 {
-    SDL_SetRenderTarget(renderer.get(), nullptr);
+    RenderState::of(renderer.get()).target(nullptr);
 }
 
 //inline void render_cropped_surface(Renderer const& renderer, Surface const& surface, int x, int y)
@@ -198,16 +244,20 @@ inline void reset_target(Renderer const& renderer)
 
 inline void render_surface(Renderer const& renderer, Surface const& surface, int x, int y)
 {
-    render_texture(renderer, make_texture_from_surface(renderer, surface), x, y);
+    render_surface(renderer, surface, x, y, surface->w, surface->h);
 }
 
 inline void render_surface(Renderer const& renderer, Surface const& surface, int x, int y, int w, int h)
 {
-    render_texture(renderer, make_texture_from_surface(renderer, surface), x, y, w, h);
+    draw_surface(renderer, surface, {x, y, w, h});
 }
 
 inline void render_texture(Renderer const& renderer, Texture const& texture, SDL_Rect const& dest)
 {
+    if (auto list = DisplayList::recording())
+        list->copy(texture.get(), nullptr, dest);
+    if (auto batch = RenderBatch::active())
+        return batch->copy(texture.get(), nullptr, dest);
     SDL_RenderCopy(renderer.get(), texture.get(), nullptr, &dest);
 }
 
@@ -227,7 +277,7 @@ inline void render_texture(Renderer const& renderer, Texture const& texture, int
 inline void draw_simple_text(Renderer const& renderer, int x, int y, SharedFont const& font, std::string const& text)
 {
     if (font)
-        FC_Draw(font.get(), renderer.get(), x, y, text.data());
+        FC_DrawText(font.get(), renderer.get(), x, y, text.data(), text.size());
 }
 
 inline void draw_centered_text(Renderer const& renderer, SDL_Rect const& bounds, SharedFont const& font, std::string const& text)
@@ -237,18 +287,31 @@ inline void draw_centered_text(Renderer const& renderer, SDL_Rect const& bounds,
 
 inline void draw_rect(Renderer const& renderer, SDL_Rect const& rect, SDL_Color const& color)
 {
+    if (auto list = DisplayList::recording())
+        list->outline_rect(rect, color);
+    if (auto batch = RenderBatch::active())
+        return batch->outline_rect(rect, color);
     set_render_color(renderer, color);
     SDL_RenderDrawRect(renderer.get(), &rect);
 }
 
 inline void draw_filled_rect(Renderer const& renderer, SDL_Rect const& rect, SDL_Color const& color)
 {
+    if (auto list = DisplayList::recording())
+        list->fill_rect(rect, color);
+    if (auto batch = RenderBatch::active())
+        return batch->fill_rect(rect, color);
     set_render_color(renderer, color);
     SDL_RenderFillRect(renderer.get(), &rect);
 }
 
 inline void draw_surface(Renderer const& renderer, Surface const& surface, SDL_Rect const& dest)
 {
+    //  the texture is temporary: it can neither be replayed nor batched
+    if (auto list = DisplayList::recording())
+        list->mark_volatile();
+    if (auto batch = RenderBatch::active())
+        batch->flush();
     Texture texture = make_texture_from_surface(renderer, surface);
     SDL_RenderCopy(renderer.get(), texture.get(), nullptr, &dest);
 }
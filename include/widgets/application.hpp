@@ -23,7 +23,11 @@
 
 #include "widgets/baseapplication.hpp"
 #include "widgets/canvas.hpp"
+#include "widgets/focusmanager.hpp"
 
+#include "framescheduler.hpp"
+#include "glyphloader.hpp"
+#include "inputrecorder.hpp"
 #include "themes.hpp"
 #include "types.hpp"
 #include "utility.hpp"
@@ -33,6 +37,7 @@
 #include "sdl_ttf_inc.hpp"
 
 #include <list>
+#include <vector>
 
 
 //  TODO: allow decoupling of TTF, MIX modules with preprocessor commands?
@@ -44,6 +49,39 @@
  * @note    Fonts, music, and items added by their respective add() functions
  *          will be managed by Application.
  *
+ * @note    Frames are paced by a FrameScheduler: loop() runs on a fixed timestep
+ *          (see update_rate()) while rendering is capped at frame_rate(). Pass
+ *          SDL_RENDERER_PRESENTVSYNC in `renderer_flags` to pace frames by the display instead.
+ *
+ * @note    In idle mode (see idle_mode()), run() blocks on SDL_WaitEventTimeout() while
+ *          there is nothing to do, i.e. no input arrived, no canvas needs a redraw and
+ *          the application isn't kept awake. Nothing is rendered while the window is
+ *          minimized or hidden, regardless of the mode.
+ *
+ * @note    With dirty-rect rendering (see dirty_rect_rendering()), frames are drawn onto a
+ *          persistent backing texture and only the union of the regions damaged since the
+ *          last frame is repainted. Frames where nothing was damaged are skipped entirely.
+ *          Widgets must report changes through WidgetItem::invalidate() or Canvas::damage().
+ *
+ * @note    With input coalescing (see input_coalescing()), consecutive mouse motion events
+ *          are merged into one (keeping the last position and button state, and summing the
+ *          relative motion), and consecutive wheel events into one (summing the deltas), before
+ *          being dispatched. Other events are dispatched as they are, in their original order.
+ *
+ * @note    A headless application (see the constructor) has no window: it renders through a
+ *          software renderer onto an offscreen surface, with SDL's dummy drivers. Drive it with
+ *          step() instead of run(), feed it input with SDL_PushEvent(), and inspect the result
+ *          with read_pixels(). This is meant for automated (e.g. CI, golden-image) tests.
+ *
+ * @note    Input can be recorded to a file (see record_input()) and replayed deterministically
+ *          (see replay()): the same events are dispatched in the same frames, with the same number
+ *          of updates in between. Replays report frame timings, which turns demos and apps into
+ *          repeatable performance scenarios. Real input is ignored while replaying, except for quitting.
+ *
+ * @note    Key events are routed through a FocusManager (see focus_manager()): they go to the
+ *          focused widget and bubble up its parents, ending at the application itself.
+ *          Pressing a mouse button focuses the innermost focusable widget under the cursor.
+ *
  * @note    When switching scenes:
  *           - the active_music is reset
  *           - all children of Application are hidden
@@ -58,10 +96,15 @@ public:
     Uint32 renderer_flags;
     
 public:
+    /**
+     * @param   headless If true, no window is created and frames are rendered offscreen
+     *          (window_flags and renderer_flags are then ignored)
+     */
     Application(SDL_Rect const& dimensions,
                 std::string const& window_title = "",
                 Uint32 window_flags = SDL_WINDOW_SHOWN,
-                Uint32 renderer_flags = SDL_RENDERER_ACCELERATED);
+                Uint32 renderer_flags = SDL_RENDERER_ACCELERATED,
+                bool headless = false);
     
     virtual ~Application();
     
@@ -71,12 +114,47 @@ public:
      */
     int run();
     
+    /**
+     * @brief   Executes the program, recording or replaying input as requested on the command line:
+     *            --record FILE         records input to FILE while running
+     *            --replay FILE         replays FILE at its original speed instead of running, then
+     *                                  prints the replay statistics to stdout
+     *            --replay-fast FILE    same as --replay, as fast as possible
+     */
+    int run(int argc, const char* argv[]);
+    
+    /**
+     * @brief   Records input received by subsequent calls to run() or step() to `filename`,
+     *          until the application is destroyed
+     * @throws  std::runtime_error if the file can't be opened
+     */
+    void record_input(std::string const& filename);
+    
+    /**
+     * @brief   Replays a recording made with record_input() instead of running, and returns how long it took
+     * @param   realtime If true, frames are replayed at the pace they were recorded at, otherwise
+     *          as fast as possible
+     * @throws  std::runtime_error if the recording can't be loaded
+     */
+    ReplayStats replay(std::string const& filename, bool realtime = false);
+    
+    /**
+     * @brief   Runs a single frame without pacing: handles pending events, calls loop()
+     *          `updates` times and renders
+     * @return  false once the application quit, true otherwise
+     */
+    bool step(unsigned updates = 1);
+    
     /**
      * @brief   Creates a managed font
+     * @param   charset Glyphs (UTF-8, e.g. Charset::ASCII or Charset::LATIN_1) to rasterize on a worker
+     *          thread; they're uploaded to the font's atlas before the next frame is rendered.
+     *          If empty, ASCII is rasterized upfront and other glyphs on first use.
      * @return  Returns a reference to the font
      * @pre     Renderer should be initialised, otherwise a null FontRef is returned.
      */
-    FontRef add_font(std::string const& filename, Uint32 point_size, SDL_Color const& color, int style = TTF_STYLE_NORMAL);
+    FontRef add_font(std::string const& filename, Uint32 point_size, SDL_Color const& color, int style = TTF_STYLE_NORMAL,
+                     std::string const& charset = "");
     
     /**
      * @brief   Creates a managed music object, works similar to add_font()
@@ -85,6 +163,49 @@ public:
      */
     MusicRef add_music(std::string const& filename);
     
+    /**
+     * @brief   Sets the target number of frames rendered per second (0 uncaps the frame rate)
+     * @note    Ignored if the renderer was created with vsync (SDL_RENDERER_PRESENTVSYNC)
+     */
+    void frame_rate(unsigned fps);
+    
+    /**
+     * @brief   Sets the number of times loop() is called per second, independent of the frame rate
+     *          (0 calls loop() exactly once per frame)
+     */
+    void update_rate(unsigned ups);
+    
+    /**
+     * @brief   Enables or disables idle mode. In idle mode, the application only wakes
+     *          up on input, on redraw() or while kept awake, and uses no CPU otherwise.
+     */
+    void idle_mode(bool on);
+    
+    /**
+     * @brief   Enables or disables dirty-rect rendering, i.e. only repainting damaged regions
+     * @note    Falls back to repainting every frame if the backing texture can't be created.
+     */
+    void dirty_rect_rendering(bool on);
+    
+    /**
+     * @brief   Enables or disables merging of consecutive mouse motion and wheel events,
+     *          so that fast drags and scrolls walk the widget tree once per frame
+     *          instead of once per event
+     */
+    void input_coalescing(bool on);
+    
+    /**
+     * @brief   Keeps rendering frames continuously for the next `ms` milliseconds, even in
+     *          idle mode. Use this while animations or timers are running.
+     */
+    void keep_awake(Uint32 ms);
+    
+    /**
+     * @brief   Wakes up an idling application so that it renders a frame.
+     * @note    Thread-safe. Call this after calling redraw() from a thread other than the main thread.
+     */
+    void wake() const;
+    
     /**
      * @brief   Adds a scene to the application
      */
@@ -96,6 +217,22 @@ public:
     
     /// accessors:
     Renderer const& get_renderer() const;
+    virtual FocusManager* focus_manager() override;
+    bool is_headless() const;
+    
+    /**
+     * @brief   Reads back the last rendered frame, or a region of it, as RGBA8888 pixels
+     *          (row by row, top to bottom)
+     * @note    Without dirty-rect rendering, a windowed application's back buffer is undefined
+     *          after it is presented, so the result is only reliable when headless.
+     */
+    std::vector<Uint32> read_pixels() const;
+    std::vector<Uint32> read_pixels(SDL_Rect const& region) const;
+    unsigned frame_rate() const;
+    unsigned update_rate() const;
+    bool idle_mode() const;
+    bool dirty_rect_rendering() const;
+    bool input_coalescing() const;
     
     template<class Enum>
     Enum get_scene() const;
@@ -120,27 +257,75 @@ protected:
     
 private:
     Window window;
+    Surface target;                 //  offscreen render target when headless
     Renderer renderer;
+    Texture frame;                  //  backing texture for dirty-rect rendering
     
     std::list<SharedFont> fonts;    //  manages fonts, deleting them at the end
     std::list<SharedMusic> music;   //  manages music
+    GlyphLoader glyph_loader;       //  rasterizes font charsets in the background
     
     MusicRef active_music;
     bool active_music_changed;      //  a flag checking whether the active music has changed
     
+    bool idle_enabled;              //  whether to block on events while there is nothing to do
+    bool dirty_rects_enabled;       //  whether to repaint damaged regions only
+    bool coalescing_enabled;        //  whether to merge consecutive motion/wheel events
+    bool window_visible;            //  false while the window is minimized or hidden
+    bool frame_pending;             //  whether an event arrived that may have changed something on screen
+    Uint32 awake_until;             //  ticks until which frames are rendered continuously
+    Uint32 wake_event;              //  user event type pushed by wake()
+    
     StateMachine scene_handler;
+    FrameScheduler scheduler;
+    FocusManager focus_handler;
+    InputRecorder recorder;
     
 private:
     /// GUI events:
+    /**
+     * @brief   Drains the event queue, passing each event (or merged run of events) to handle_event()
+     */
+    void poll_events();
+    
+    /**
+     * @brief   Merges `event` into `pending` if both are motion events or both are wheel
+     *          events from the same source
+     * @return  true if merged
+     */
+    static bool coalesce(SDL_Event& pending, SDL_Event const& event);
+    
+    /**
+     * @brief   Passes `event` to handle_event(), or merges it into `pending` when coalescing.
+     *          `pending` must be passed to handle_event() once there are no more events.
+     */
+    void dispatch_event(SDL_Event const& event, SDL_Event& pending, bool& has_pending);
+    
     /**
      * @brief   Passes events to child items
      */
     bool handle_event(SDL_Event const& event);
     
+    /**
+     * @brief   Focuses the innermost focusable widget on the hovered path, if any
+     */
+    void focus_hovered();
+    
+    /**
+     * @brief   Checks whether there is nothing to update or render
+     */
+    bool is_idle() const;
+    
+    /**
+     * @brief   Updates child canvases. The application's own damage is consumed by render().
+     */
+    virtual void update(Renderer const&) override;
+    
     /**
      * @brief   Renders child items on the window
+     * @return  false if nothing needed repainting, true otherwise
      */
-    void render() const;
+    bool render();
 };
         
 /// inline implementation:
@@ -154,6 +339,7 @@ template<class Enum>
 inline void Application::set_scene(Enum scene)
 {
     scene_handler.set_next_state(scene);
+    redraw();   //  make sure the scene change gets picked up in idle mode
 }
 
 template<class Enum>
@@ -23,19 +23,25 @@
 
 #include "rectitem.hpp"
 
+#include "displaylist.hpp"
+#include "renderbatch.hpp"
+#include "spatialgrid.hpp"
 #include "themes.hpp"
 #include "types.hpp"
 #include "utility.hpp"
 
 #include "sdl_inc.hpp"
 
-#include <list>
 #include <map>
+#include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 #include <cstdint>
 
 
+class FocusManager;
+
 /**
  * @brief   Manages children and caches drawn stuff onto a texture. Renders
  *          child items and canvases RELATIVE to the parent canvas.
@@ -45,6 +51,28 @@
  * @note    The default redraw does (1) clear, (2) render children.
  *          A custom redraw replaces step 2. Note that the renderer passed
  *          will target the canvas, such that items are drawn relatively.
+ *
+ * @note    Children report damaged regions through damage() (see WidgetItem::invalidate()).
+ *          On update(), only the union of the damaged regions is repainted (the renderer's
+ *          clip rect is set to it), unless redraw() was called. Damage also propagates up
+ *          to the parent canvas.
+ *
+ * @note    Each canvas also keeps a "subtree dirty" bit, set whenever a descendant canvas
+ *          is damaged. update() skips children whose subtree is clean, so static parts
+ *          of the tree cost O(1) per frame.
+ *
+ * @note    Children are stored contiguously in insertion order, which is also the order
+ *          they are rendered in (later children are drawn on top). A child's ItemID is
+ *          its position in that order, so lookups and show()/hide() are O(1).
+ *
+ * @note    With a display list (see display_list()), the draw calls of each child are recorded
+ *          the first time it renders and replayed afterwards, until the child is invalidated.
+ *
+ * @note    With batch rendering (see batch_rendering()), children are drawn through a RenderBatch,
+ *          which merges their draw calls.
+ *
+ * @note    Children outside the renderer's viewport and clip rect aren't rendered (see viewport_culling()),
+ *          so a partial redraw only renders the children overlapping the damaged region.
  */
 class Canvas : public RectItem
 {
@@ -66,6 +94,9 @@ public:
     /// constructors:
     /**
      * These constructors will NOT initialise a texture (i.e. the canvas will use a null texture).
+     * Such a canvas draws its background and children in place each time it is rendered,
+     * relative to and clipped to its dimensions. Prefer this for static panels, which don't
+     * need video memory of their own.
      */
     Canvas(int width, int height);
     Canvas(SDL_Rect const&);
@@ -100,6 +131,68 @@ public:
      */
     Canvas& redraw();
     
+    /**
+     * @brief   Marks a region (relative to the canvas) as needing a repaint.
+     *          The region is repainted the next time update() is called.
+     */
+    Canvas& damage(SDL_Rect const& region);
+    
+    /**
+     * @brief   Indexes children in a uniform grid, so that mouse and wheel events are only
+     *          forwarded to the children under the cursor instead of to every child.
+     *          The index is kept up to date as children are added, moved or resized.
+     *          Pass 0 to disable it (the default).
+     *
+     * @note    With the index enabled, children only receive events that lie within their
+     *          dimensions. Don't enable it if children rely on events outside of themselves.
+     */
+    Canvas& spatial_index(int cell_size = SpatialGrid::DEFAULT_CELL_SIZE);
+    
+    /**
+     * @brief   Makes the canvas a focus scope: Tab traversal stays within it while one of
+     *          its descendants has focus, and it remembers its last focused descendant,
+     *          which is restored when the canvas itself is focused (see FocusManager).
+     */
+    Canvas& focus_scope(bool on);
+    
+    /**
+     * @brief   Records the draw calls of the children into a DisplayList and replays them on later
+     *          redraws instead of calling each child's render(). A child's recording is dropped
+     *          when it is invalidated (see WidgetItem::invalidate()). Ignored with on_redraw().
+     *
+     * @note    Children must draw through the render utility functions (draw_rect(), draw_text(), ...)
+     *          and call invalidate() whenever their appearance changes. Drawing done by calling SDL
+     *          directly is not recorded, so it would be lost on replay.
+     */
+    Canvas& display_list(bool on);
+    
+    /**
+     * @brief   Draws the children through a RenderBatch, so that consecutive rects of one colour
+     *          and glyphs from one font atlas are submitted in a single SDL call each.
+     *
+     * @note    Children that change renderer state or draw by calling SDL directly must call
+     *          RenderBatch::active()->flush() beforehand, or their drawing will be out of order.
+     */
+    Canvas& batch_rendering(bool on);
+    
+    /**
+     * @brief   Skips rendering children which lie entirely outside the renderer's current
+     *          viewport and clip rect. On by default.
+     *
+     * @note    Children are assumed to draw within their dimensions. Children with empty
+     *          dimensions are never culled.
+     */
+    Canvas& viewport_culling(bool on);
+    
+    /**
+     * @brief   Skips rendering children which are entirely covered by an opaque sibling drawn
+     *          after them (see WidgetItem::is_opaque()). Off by default.
+     *
+     * @note    Only a handful of the largest opaque siblings are considered as occluders, and
+     *          a child must be covered by a single one of them to be culled.
+     */
+    Canvas& occlusion_culling(bool on);
+    
     /**
      * @brief   Adds an item to the canvas. The item will be fully managed by
      *          the canvas (i.e. it will be deleted when the Canvas is destroyed).
@@ -118,6 +211,19 @@ public:
     ItemID add_canvas(std::string const& name, Canvas*);
     ItemID add_canvas(Canvas*);
     
+    /**
+     * @brief   Adds several (anonymous) items at once. Items are managed as with add_item().
+     * @return  The id of the first item added; the others follow consecutively.
+     *          0 if `items` is empty.
+     */
+    ItemID add_items(std::vector<WidgetItem*> const& items);
+    
+    /**
+     * @brief   Reserves storage for `n` children in total, so that adding many
+     *          children doesn't repeatedly reallocate
+     */
+    void reserve(std::size_t n);
+    
 //    void remove(WidgetItem*);
 //    void remove(ItemID);
     
@@ -128,12 +234,24 @@ public:
      *
      * @param   flags Which children to apply the function on.
      *          (e.g. flags == VISIBLE | CANVASES will only apply the function
-     *          on visible canvases)
+     *          on visible canvases). If neither ITEMS nor CANVASES is given, both
+     *          are included; likewise for VISIBLE and INVISIBLE.
+     *
+     * @note    Children are visited in insertion (z-)order.
+     * @note    This goes through a type-erased call per child; prefer for_each_child()
+     *          on hot paths.
      */
     void foreach_child(std::function<void(WidgetItem*)>, ChildFlags flags = ALL);
     
     /**
-     * @brief   Shows/hides a child by item id.
+     * @brief   Same as foreach_child(), but takes any callable `void(WidgetItem*)`,
+     *          so that the call can be inlined
+     */
+    template<class Visitor>
+    void for_each_child(Visitor&& visit, ChildFlags flags = ALL);
+    
+    /**
+     * @brief   Shows/hides a child by item id. O(1).
      */
     void show(ItemID);
     void hide(ItemID);
@@ -153,10 +271,62 @@ public:
      */
     void foreach_child(std::function<void(WidgetItem*)>, ChildFlags = ALL) const;
     
+    template<class Visitor>
+    void for_each_child(Visitor&& visit, ChildFlags flags = ALL) const;
+    
+    /**
+     * @brief   Checks whether the canvas or any of its descendant canvases
+     *          will redraw the next time update() is called. O(1).
+     */
+    bool needs_update() const;
+    
+    /**
+     * @brief   The child the cursor is hovering over (see update_hover()), or nullptr
+     */
+    WidgetItem* hovered_child() const;
+    
+    bool is_focus_scope() const;
+    
+    /**
+     * @brief   A canvas is opaque if it renders a texture filled with an opaque background,
+     *          unless the texture is blended additively or by modulation
+     */
+    virtual bool is_opaque() const override;
+    
+    /**
+     * @brief   The focus manager of the tree this canvas belongs to, or nullptr if none.
+     *          Canvases ask their parent; the root (e.g. Application) provides it.
+     */
+    virtual FocusManager* focus_manager();
+    
     /// GUI functions:
+    /**
+     * @brief   Forwards mouse/wheel events to visible children, topmost (last added) first.
+     *          Propagation stops at the first child that handles the event, so events
+     *          don't fall through stacked widgets.
+     *
+     *          Before that, the event goes through the capture phase (see capture_mouse_event()).
+     *
+     * @note    The child which handled the last mouse event is cached. While the cursor stays
+     *          inside it (and nothing above it overlaps it), later mouse events go straight to
+     *          it without hit-testing other children, so dispatch is O(depth).
+     */
     virtual bool handle_mouse_event(MouseEvent const&) override;
     virtual bool handle_wheel_event(WheelEvent const&) override;
     
+    /**
+     * @brief   Makes the children which handled the last mouse event the hovered path,
+     *          calling handle_mouse_leave()/handle_mouse_enter() on children that left/joined it.
+     *          Application calls this after dispatching each mouse event.
+     * @param   event The event last passed to handle_mouse_event()
+     */
+    void update_hover(MouseEvent const& event);
+    
+    /**
+     * @brief   Also leaves the hovered child (and so on down the hovered path)
+     */
+    virtual void handle_mouse_leave(MouseEvent const&) override;
+    
     /**
      * @brief   Update child canvases and perform the actual redraw
      *          Invisible child canvases are not updated
@@ -166,7 +336,8 @@ public:
     /**
      * @brief   The sole responsibility of this override is to render the cached texture.
      *          Use redraw() and update() to update the texture.
-     * @pre     make() the canvas first
+     *          Texture-less canvases render their background and children instead, inside
+     *          a render context (see RenderState::push_context()).
      */
     virtual void render(Renderer const&) const override;
     void render_children(Renderer const&) const;
@@ -174,20 +345,57 @@ public:
     /// convenience functions:
     void swap(Canvas&) noexcept;
     
+protected:
+    /**
+     * @brief   Capture phase: called with the (canvas-relative) event before it is forwarded
+     *          to any child. Override to intercept events meant for children (e.g. to implement
+     *          dragging or modal behaviour).
+     * @return  true to consume the event, so that children don't receive it.
+     *          The default implementation returns false.
+     */
+    virtual bool capture_mouse_event(MouseEvent const&);
+    virtual bool capture_wheel_event(WheelEvent const&);
+    
+    /**
+     * @brief   Updates visible child canvases that need it, without redrawing this canvas
+     */
+    void update_children(Renderer const&);
+    
+    /**
+     * @brief   Returns the region that needs a repaint (the whole canvas after redraw())
+     *          and resets it. The returned rect is empty if nothing needs a repaint.
+     */
+    SDL_Rect consume_damage();
+    
 private:
     Texture m_texture;
     RedrawFunc m_on_redraw;
     bool m_redraw;   //  whether canvas will redraw next render or not
+    SDL_Rect m_damage;  //  union of damaged regions, relative to the canvas (empty if none)
+    bool m_subtree_dirty;   //  whether a descendant canvas needs an update
     
     //  child widgets stored here will be rendered relative to the Canvas
-    std::map<ItemID, std::unique_ptr<Canvas>> m_visible_canvases;
-    std::map<ItemID, std::unique_ptr<Canvas>> m_invisible_canvases;
-    
-    std::map<ItemID, std::unique_ptr<WidgetItem>> m_visible_items;
-    std::map<ItemID, std::unique_ptr<WidgetItem>> m_invisible_items;
+    //  a child with id `id` lives at index `id - 1` of each of these
+    std::vector<std::unique_ptr<WidgetItem>> m_children;    //  in insertion (z-)order
+    std::vector<bool> m_visible;    //  visibility bitset
+    std::vector<bool> m_is_canvas;
+    std::vector<ItemID> m_canvas_ids;   //  ids of child canvases, in insertion order
     std::map<std::string, ItemID> m_name_to_id;
+    std::unique_ptr<SpatialGrid> m_spatial_index;   //  null if disabled
+    std::unique_ptr<DisplayList> m_display_list;    //  null if disabled, slice `id - 1` holds child `id`
+    bool m_batching;
+    bool m_viewport_culling;
+    bool m_occlusion_culling;
+    mutable std::vector<bool> m_occluded;   //  scratch space for draw_children(), by child index
+    
+    //  hit cache: the child which handled the last mouse event
+    ItemID m_hit;           //  0 if none
+    bool m_hit_valid;       //  false if children changed since
+    bool m_hit_exclusive;   //  whether no visible child above overlaps the hit child
+    ItemID m_hovered;       //  the hit child, as of the last update_hover()
     
-    ItemID m_id_counter = 0;    //  used for keeping track of ID and for generating names of unnamed children
+    bool m_focus_scope;
+    WidgetItem* m_scope_focus;  //  weak pointer, last focused descendant if this is a focus scope
     
 private:
     /// helper functions:
@@ -196,7 +404,71 @@ private:
      */
     Canvas& clear(Renderer const&);
     
-    void perform_redraw(Renderer const&);
+    /**
+     * @brief   Renders the visible children, replaying their display list slices if enabled
+     */
+    void draw_children(Renderer const&) const;
+    
+    /**
+     * @brief   Gets the part of the renderer's target children can be seen in:
+     *          the current viewport (in viewport coordinates), narrowed by the clip rect
+     * @return  false if the renderer doesn't report a viewport, in which case nothing should be culled
+     */
+    static bool visible_area(Renderer const&, SDL_Rect& area);
+    
+    /**
+     * @brief   Flags the visible children which are covered by an opaque sibling above them in `m_occluded`
+     * @param   area The visible area, or nullptr if unknown
+     */
+    void find_occluded(SDL_Rect const* area) const;
+    
+    /**
+     * @brief   Redraws the region (relative to the canvas), clipping drawing to it
+     */
+    void perform_redraw(Renderer const&, SDL_Rect const& region);
+    
+    /**
+     * @brief   Flags this canvas' subtree as dirty and bubbles the flag up to the root,
+     *          stopping early at the first ancestor that is already flagged
+     */
+    void mark_subtree_dirty();
+    
+    /**
+     * @brief   Takes ownership of a child and assigns it the next id
+     */
+    ItemID adopt(WidgetItem*, bool is_canvas);
+    
+    /// @brief  Checks whether a child matches the given flags
+    bool matches(std::size_t index, ChildFlags) const;
+    
+    /**
+     * @brief   Forwards a (canvas-relative) mouse/wheel event to the visible children
+     *          that may be interested, using the spatial index if enabled
+     * @return  true if a child handled the event
+     */
+    template<class Event, class Handler>
+    bool dispatch(Event const&, Handler&&);
+    
+    /**
+     * @brief   Hit-tests the (canvas-relative) mouse event against the children and forwards it
+     * @return  The id of the child which handled the event, 0 if none did
+     */
+    ItemID route_mouse_event(MouseEvent const&);
+    
+    /// @brief  Checks whether no visible child above the given one overlaps it
+    bool is_exclusive(ItemID) const;
+    
+    /// @brief  Called by WidgetItem when a child's dimensions change
+    void child_moved(WidgetItem const&, SDL_Rect const& from);
+    
+    /// @brief  Called by WidgetItem when anything affecting hit-testing changes
+    void child_changed(WidgetItem const&);
+    
+    /// @brief  Called by WidgetItem::invalidate(): drops the child's recording and damages its area
+    void child_invalidated(WidgetItem const&);
+    
+    friend class WidgetItem;
+    friend class FocusManager;
 };
 
 
@@ -205,13 +477,35 @@ inline Canvas::Canvas(int width, int height) : Canvas({0, 0, width, height}) {}
 inline Canvas::Canvas(SDL_Rect const& dimensions)
     : Super(dimensions)
     , m_redraw{true}
+    , m_damage{0, 0, 0, 0}
+    , m_subtree_dirty{false}
+    , m_batching{false}
+    , m_viewport_culling{true}
+    , m_occlusion_culling{false}
+    , m_hit{0}
+    , m_hit_valid{false}
+    , m_hit_exclusive{false}
+    , m_hovered{0}
+    , m_focus_scope{false}
+    , m_scope_focus{nullptr}
 {
 }
 inline Canvas::Canvas(int width, int height, Renderer const& renderer, Canvas* parent, std::string const& name) : Canvas({0, 0, width, height}, renderer, parent, name) {}
 inline Canvas::Canvas(SDL_Rect const& dimensions, Renderer const& renderer, Canvas* parent, std::string const& name)
     : Super(dimensions)
-    , m_redraw{true}
     , m_texture{make_texture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, dimensions.w, dimensions.h)}
+    , m_redraw{true}
+    , m_damage{0, 0, 0, 0}
+    , m_subtree_dirty{false}
+    , m_batching{false}
+    , m_viewport_culling{true}
+    , m_occlusion_culling{false}
+    , m_hit{0}
+    , m_hit_valid{false}
+    , m_hit_exclusive{false}
+    , m_hovered{0}
+    , m_focus_scope{false}
+    , m_scope_focus{nullptr}
 {
     if ((m_parent = parent))
         m_parent->add_canvas(name, this);
@@ -220,5 +514,34 @@ inline Canvas::Canvas(SDL_Rect const& dimensions, Renderer const& renderer, Canv
 /// destructors:
 inline Canvas::~Canvas() = default;
 
+/// modifiers:
+template<class Visitor>
+void Canvas::for_each_child(Visitor&& visit, ChildFlags flags)
+{
+    //  indices are re-checked against size() on each iteration, so `visit` may add children
+    for (std::size_t i = 0; i < m_children.size(); ++i)
+        if (matches(i, flags))
+            visit(m_children[i].get());
+}
+
+/// accessors:
+template<class Visitor>
+void Canvas::for_each_child(Visitor&& visit, ChildFlags flags) const
+{
+    for (std::size_t i = 0; i < m_children.size(); ++i)
+        if (matches(i, flags))
+            visit(m_children[i].get());
+}
+
+/// helper functions:
+inline bool Canvas::matches(std::size_t index, ChildFlags flags) const
+{
+    //  an unspecified category matches everything
+    const int visibility = (flags & (VISIBLE | INVISIBLE)) ? flags : (VISIBLE | INVISIBLE);
+    const int kind = (flags & (ITEMS | CANVASES)) ? flags : (ITEMS | CANVASES);
+    return (visibility & (m_visible[index] ? VISIBLE : INVISIBLE))
+        && (kind & (m_is_canvas[index] ? CANVASES : ITEMS));
+}
+
 
 #endif /* canvas_hpp */
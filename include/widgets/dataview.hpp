@@ -38,6 +38,7 @@ class Canvas;
  *                             only about visualisation and user interaction.
  *
  * @note    Inherited classes will need to implement render_item().
+ * @note    The view listens to its model and invalidates itself when the model changes.
  *
  * @note    Handler events: SDL_MOUSEBUTTONDOWN, SDL_MOUSEWHEEL, (inherited events)
  * @note    Inherited classes may also override internal_width(),
@@ -83,6 +84,8 @@ public:
     /// GUI functions:
     virtual bool handle_mouse_event(MouseEvent const& event) override;
     virtual bool handle_wheel_event(WheelEvent const& event) override;
+    virtual void handle_mouse_enter(MouseEvent const& event) override;
+    virtual void handle_mouse_leave(MouseEvent const& event) override;
     virtual void render(Renderer const& renderer) const override;
     
     /// convenience functions:
@@ -92,6 +95,7 @@ protected:
     static const unsigned DEFAULT_COLUMN_RATIO = 1;
     
     const DataModel<T>* m_model;  //  weak pointer
+    typename DataModel<T>::ListenerHandle m_model_listener;
     FontRef m_item_font;
     SDL_Color m_item_color;
     Margins m_margins;
@@ -134,6 +138,9 @@ private:
 
     /// convenience functions:
     void swap_members(DataView& other) noexcept;
+    
+    /// @brief  (Re-)subscribes to change notifications from the current model
+    void listen_to_model();
 };
 
 
@@ -152,6 +159,7 @@ inline DataView<T>::DataView(SDL_Rect const& dimensions, DataModel<T>* model, Ca
     , m_item_font{TextInterface::default_font()}
 {
     assert(m_model != nullptr);
+    listen_to_model();
 }
 
 /// destructor:
@@ -160,15 +168,24 @@ inline DataView<T>::~DataView() = default;
 
 /// modifiers:
 template<class T>
-inline DataView<T>& DataView<T>::model(DataModel<T>* model) { if (model) m_model = model; return *this; }
+DataView<T>& DataView<T>::model(DataModel<T>* model)
+{
+    if (model && model != m_model)
+    {
+        m_model = model;
+        listen_to_model();
+        invalidate();
+    }
+    return *this;
+}
 template<class T>
-inline DataView<T>& DataView<T>::item_font(FontRef const& font) { if (!font.expired()) m_item_font = font; return *this; }
+inline DataView<T>& DataView<T>::item_font(FontRef const& font) { if (!font.expired()) { m_item_font = font; invalidate(); } return *this; }
 template<class T>
-inline DataView<T>& DataView<T>::margins(Margins const& margins) { m_margins = margins; return *this; }
+inline DataView<T>& DataView<T>::margins(Margins const& margins) { m_margins = margins; invalidate(); return *this; }
 template<class T>
-inline DataView<T>& DataView<T>::item_padding(Padding const& padding) { m_item_padding = padding; return *this; }
+inline DataView<T>& DataView<T>::item_padding(Padding const& padding) { m_item_padding = padding; invalidate(); return *this; }
 template<class T>
-inline DataView<T>& DataView<T>::item_height(int height) { m_item_height = height; return *this; }
+inline DataView<T>& DataView<T>::item_height(int height) { m_item_height = height; invalidate(); return *this; }
 template<class T>
 inline DataView<T>& DataView<T>::on_scrolled(WheelEventCallback f) { m_scrolled = f; return *this; }
 template<class T>
@@ -207,12 +224,21 @@ bool DataView<T>::handle_wheel_event(WheelEvent const& event)
         return true;
     
     int max_display_index = std::max(int(m_model->rows()) - get_nb_display_items(), 0);
-    m_display_index -= delta;
-    m_display_index = std::min(std::max(m_display_index, 0), max_display_index);
+    int display_index = std::min(std::max(m_display_index - delta, 0), max_display_index);
+    if (display_index != m_display_index)
+    {
+        m_display_index = display_index;
+        invalidate();
+    }
     if (m_scrolled) m_scrolled(event);
     return true;
 }
 
+template<class T>
+inline void DataView<T>::handle_mouse_enter(MouseEvent const& event) { entered(event); }
+template<class T>
+inline void DataView<T>::handle_mouse_leave(MouseEvent const& event) { left(event); }
+
 template<class T>
 void DataView<T>::render(Renderer const& renderer) const
 {
@@ -226,6 +252,10 @@ void DataView<T>::swap(DataView& other) noexcept
 {
     Super::swap(other);
     swap_members(other);
+    
+    //  listeners capture `this`, so each view re-subscribes to the model it now holds
+    listen_to_model();
+    other.listen_to_model();
 }
 
 /// general helper functions:
@@ -296,5 +326,11 @@ void DataView<T>::swap_members(DataView& other) noexcept
     std::swap(m_index_hovered, other.m_index_hovered);
 }
 
+template<class T>
+void DataView<T>::listen_to_model()
+{
+    m_model_listener = m_model->on_changed([this]{ invalidate(); });
+}
+
 
 #endif
@@ -0,0 +1,113 @@
+/*
+ *      Copyright (C) 2020 Johnathan Law
+ *
+ *      This file is part of SWL.
+ *
+ *      SWL is free software: you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation, either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      SWL is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with SWL.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef FOCUSMANAGER_HPP
+#define FOCUSMANAGER_HPP
+
+#include "types.hpp"
+
+#include <vector>
+
+
+class Canvas;
+class WidgetItem;
+
+/**
+ * @brief   Keeps track of the widget with keyboard focus, and routes key events to it.
+ *
+ * @note    Key events go to the focused widget first and then bubble up its parent chain
+ *          (up to and including the root) until a handle_key_event() returns true. Other
+ *          widgets never see them. Without a focused widget, key events go to the root.
+ *
+ * @note    Tab/Shift+Tab moves focus to the next/previous focusable widget (see
+ *          WidgetItem::focusable()), in depth-first z-order, if no widget on the chain
+ *          handled the key. Traversal wraps around within the focused widget's focus scope
+ *          (see Canvas::focus_scope()); nested scopes count as a single stop, which
+ *          focuses the widget last focused in that scope.
+ *
+ * @note    Only visible and enabled widgets can take focus. If the focused widget is
+ *          hidden or disabled, it loses focus the next time a key is routed.
+ */
+class FocusManager
+{
+public:
+    /// constructors:
+    FocusManager(Canvas& root) noexcept;
+    FocusManager(FocusManager const&) = delete;
+    
+    /// assignment:
+    FocusManager& operator= (FocusManager const&) = delete;
+    
+    /// modifiers:
+    /**
+     * @brief   Focuses the given widget. Focusing a focus scope which isn't focusable itself
+     *          focuses the widget last focused in it (or its first focusable widget).
+     *          Passing nullptr clears the focus.
+     * @return  true if the focus was set, false if the widget can't take focus
+     */
+    bool focus(WidgetItem*);
+    void clear();
+    
+    /**
+     * @brief   Moves focus along the tab order of the current focus scope
+     * @return  true if a widget was focused
+     */
+    bool focus_next();
+    bool focus_previous();
+    
+    /// accessors:
+    WidgetItem* focused() const;
+    
+    /// GUI functions:
+    /**
+     * @brief   Routes a key event to the focused widget and bubbles it up the parent chain.
+     *          Handles Tab traversal if nobody else handled the key.
+     * @return  true if the event was handled
+     */
+    bool handle_key_event(KeyEvent const&);
+    
+private:
+    Canvas& m_root;
+    WidgetItem* m_focused;  //  weak pointer
+    
+private:
+    /// helper functions:
+    /// @brief  Checks whether the item is focusable, enabled and visible within the root
+    bool can_focus(WidgetItem const*) const;
+    
+    /// @brief  The innermost focus scope containing the item (the root if none)
+    Canvas* scope_of(WidgetItem const*) const;
+    
+    /// @brief  The widget to focus when focusing a scope
+    WidgetItem* entry_of(Canvas* scope) const;
+    
+    /// @brief  Collects tab stops of a scope in depth-first z-order
+    void collect_stops(Canvas const* canvas, std::vector<WidgetItem*>& stops) const;
+    
+    bool advance(bool forward);
+    void set_focus(WidgetItem*);
+};
+
+
+/// accessors:
+inline WidgetItem* FocusManager::focused() const { return m_focused; }
+
+
+#endif
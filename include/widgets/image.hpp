@@ -85,7 +85,9 @@ inline ImageItem& ImageItem::operator= (ImageItem&& other) noexcept
 /// modifiers:
 inline bool ImageItem::load(Renderer const& renderer, std::string const& filename)
 {
-    return bool( m_texture = make_texture(IMG_LoadTexture(renderer.get(), filename.data())) );
+    m_texture = make_texture(IMG_LoadTexture(renderer.get(), filename.data()));
+    invalidate();
+    return bool(m_texture);
 }
 
 #endif
@@ -151,17 +151,17 @@ inline ListView<T>::~ListView() = default;
 
 /// modifiers:
 template<class T>
-inline ListView<T>& ListView<T>::headers(std::vector<std::string> const& headers) { m_headers = headers; return *this; }
+inline ListView<T>& ListView<T>::headers(std::vector<std::string> const& headers) { m_headers = headers; this->invalidate(); return *this; }
 template<class T>
-inline ListView<T>& ListView<T>::column_ratios(std::vector<unsigned> const& ratios) { m_column_ratios = ratios; return *this; }
+inline ListView<T>& ListView<T>::column_ratios(std::vector<unsigned> const& ratios) { m_column_ratios = ratios; this->invalidate(); return *this; }
 template<class T>
-inline ListView<T>& ListView<T>::header_font(FontRef const& font) { if (!font.expired()) m_header_font = font; return *this; }
+inline ListView<T>& ListView<T>::header_font(FontRef const& font) { if (!font.expired()) { m_header_font = font; this->invalidate(); } return *this; }
 template<class T>
-inline ListView<T>& ListView<T>::header_height(int height) { m_header_height = height; return *this; }
+inline ListView<T>& ListView<T>::header_height(int height) { m_header_height = height; this->invalidate(); return *this; }
 template<class T>
-inline ListView<T>& ListView<T>::selection_color(SDL_Color const& color) { m_selection_color = color; return *this; }
+inline ListView<T>& ListView<T>::selection_color(SDL_Color const& color) { m_selection_color = color; this->invalidate(); return *this; }
 template<class T>
-inline ListView<T>& ListView<T>::draw_item_borders(bool draw) { m_draw_item_borders = draw; return *this; }
+inline ListView<T>& ListView<T>::draw_item_borders(bool draw) { m_draw_item_borders = draw; this->invalidate(); return *this; }
 
 /// GUI functions:
 template<class T>
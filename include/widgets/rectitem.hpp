@@ -49,6 +49,12 @@ public:
     /// modifiers:
     void background(SDL_Color const& color);
     
+    /// accessors:
+    /**
+     * @brief   A rect item is opaque if its background color is
+     */
+    virtual bool is_opaque() const override;
+    
     /// GUI functions:
     virtual void render(Renderer const& renderer) const override;
     
@@ -66,7 +72,18 @@ inline RectItem::~RectItem() = default;
 /// modifiers:
 inline void RectItem::background(SDL_Color const& color)
 {
+    auto const& bg = m_background_color;
+    if (bg.r == color.r && bg.g == color.g && bg.b == color.b && bg.a == color.a)
+        return;
+    
     m_background_color = color;
+    invalidate();
+}
+
+/// accessors:
+inline bool RectItem::is_opaque() const
+{
+    return m_background_color.a == 255;
 }
 
 
@@ -58,7 +58,12 @@ public:
     
     /// GUI functions:
     virtual bool handle_mouse_event(MouseEvent const&) override;
+    virtual void handle_mouse_enter(MouseEvent const&) override;
+    virtual void handle_mouse_leave(MouseEvent const&) override;
     virtual void render(Renderer const&) const override;
+    
+protected:
+    virtual void text_changed() override;
 };
 
 
@@ -76,5 +81,8 @@ inline TextButton::TextButton(SDL_Rect const& dimensions, Canvas* parent, std::s
 /// destructor:
 inline TextButton::~TextButton() = default;
 
+/// protected:
+inline void TextButton::text_changed() { invalidate(); }
+
 
 #endif
@@ -64,6 +64,9 @@ public:
     
     /// GUI functions:
     virtual void render(Renderer const&) const override;
+    
+protected:
+    virtual void text_changed() override;
 };
 
 
@@ -85,10 +88,13 @@ inline TextItem::TextItem(SDL_Rect const& dimensions, Alignment alignment, Canva
 /// destructor:
 inline TextItem::~TextItem() = default;
 
+/// protected:
+inline void TextItem::text_changed() { invalidate(); }
+
 /// GUI functions:
 inline void TextItem::render(Renderer const& renderer) const
 {
-    draw_text(renderer, m_dimensions, m_font.lock(), text(), m_alignment);
+    render_text(renderer, m_dimensions);
 }
 
 
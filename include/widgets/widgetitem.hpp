@@ -51,6 +51,11 @@ public:
     WidgetItem& operator= (WidgetItem&&) = delete;
     
     /// modifiers:
+    /**
+     * @note    Modifiers that change how the item is rendered (position, size, visibility,
+     *          enabled state) invalidate the item, so the parent canvas repaints it.
+     */
+    WidgetItem& dimensions(SDL_Rect const& dimensions);
     WidgetItem& pos(int x, int y);
     WidgetItem& size(int w, int h);
     WidgetItem& x(int x);
@@ -62,6 +67,25 @@ public:
     void enable();
     void disable();
     
+    /**
+     * @brief   Reports the item's area to the parent canvas as needing a repaint, and drops
+     *          its recorded draw calls if the parent uses a display list.
+     *          Call this after changing anything that affects how the item is rendered.
+     */
+    void invalidate();
+    
+    /**
+     * @brief   Sets whether the item can take keyboard focus (off by default).
+     *          Focusable items are tab stops (see FocusManager).
+     */
+    WidgetItem& focusable(bool on);
+    
+    /**
+     * @brief   Gives the item keyboard focus
+     * @return  true if the item could take focus
+     */
+    bool focus();
+    
     /// accessors:
     int x() const;
     int y() const;
@@ -74,12 +98,23 @@ public:
     /// @return true if the item is enabled, otherwise false
     virtual bool is_enabled() const;
     
+    bool is_focusable() const;
+    bool has_focus() const;
+    
+    /**
+     * @brief   Whether render() covers the whole of the item's dimensions with opaque pixels,
+     *          so that whatever lies underneath can't be seen (see Canvas::occlusion_culling()).
+     *          The default implementation returns false.
+     */
+    virtual bool is_opaque() const;
+    
     /// GUI functions:
     /**
      * @brief   Handles events.
      * @return  true if the event was handled, false otherwise.
      *          For mouse/wheel events, an event is "handled" if the item is visible.
      *          For key events, an event is "handled" if the item responds to the key.
+     *          A handled mouse/wheel event is not forwarded to items underneath.
      *
      * On a normal basis, these functions doesn't need to be overridden.
      * Override only when needed
@@ -91,6 +126,22 @@ public:
     virtual bool handle_wheel_event(WheelEvent const&);
     virtual bool handle_key_event(KeyEvent const&);
     
+    /**
+     * @brief   Called when the cursor starts/stops hovering the item, i.e. when the item
+     *          becomes/stops being the topmost item handling mouse events under the cursor.
+     *          Enter is called on outer items before inner ones; leave, the other way round.
+     *          The default implementations do nothing.
+     */
+    virtual void handle_mouse_enter(MouseEvent const&);
+    virtual void handle_mouse_leave(MouseEvent const&);
+    
+    /**
+     * @brief   Called when the item gains/loses keyboard focus.
+     *          The default implementations do nothing.
+     */
+    virtual void handle_focus_in();
+    virtual void handle_focus_out();
+    
     /**
      * @brief   Renders an item. This should be implemented such that
      *          calling render() will immediately draw the item on the
@@ -114,8 +165,10 @@ protected:
     SDL_Rect m_dimensions;
     Canvas* m_parent;   //  weak pointer    //  TODO: storing this here for now (might be useful for defining move semantics later)
     bool m_enabled;     //  whether an item should be able to interact with (useful for buttons)
+    bool m_focusable;   //  whether an item can take keyboard focus
     
     friend class Canvas;
+    friend class FocusManager;
 };
 
 
@@ -123,13 +176,13 @@ protected:
 inline WidgetItem::~WidgetItem() = default;
 
 /// modifiers:
-inline WidgetItem& WidgetItem::pos(int x, int y) { m_dimensions.x = x; m_dimensions.y = y; return *this; }
-inline WidgetItem& WidgetItem::size(int w, int h) { m_dimensions.w = w; m_dimensions.h = h; return *this; }
+inline WidgetItem& WidgetItem::pos(int x, int y) { return dimensions({x, y, m_dimensions.w, m_dimensions.h}); }
+inline WidgetItem& WidgetItem::size(int w, int h) { return dimensions({m_dimensions.x, m_dimensions.y, w, h}); }
 
-inline WidgetItem& WidgetItem::x(int x) { m_dimensions.x = x; return *this; }
-inline WidgetItem& WidgetItem::y(int y) { m_dimensions.y = y; return *this; }
-inline WidgetItem& WidgetItem::width(int width) { m_dimensions.w = width; return *this; }
-inline WidgetItem& WidgetItem::height(int height) { m_dimensions.h = height; return *this; }
+inline WidgetItem& WidgetItem::x(int x) { return pos(x, m_dimensions.y); }
+inline WidgetItem& WidgetItem::y(int y) { return pos(m_dimensions.x, y); }
+inline WidgetItem& WidgetItem::width(int width) { return size(width, m_dimensions.h); }
+inline WidgetItem& WidgetItem::height(int height) { return size(m_dimensions.w, height); }
 
 /// accessors:
 inline int WidgetItem::x() const { return m_dimensions.x; }
@@ -140,6 +193,8 @@ inline Point WidgetItem::pos() const { return {x(), y()}; }
 inline Size WidgetItem::size() const { return {width(), height()}; }
 inline SDL_Rect WidgetItem::dimensions() const { return m_dimensions; }
 inline bool WidgetItem::is_enabled() const { return m_enabled; }
+inline bool WidgetItem::is_focusable() const { return m_focusable; }
+inline bool WidgetItem::is_opaque() const { return false; }
 
 /// GUI functions:
 inline bool WidgetItem::handle_mouse_event(MouseEvent const& event)
@@ -154,6 +209,10 @@ inline bool WidgetItem::handle_key_event(KeyEvent const& event)
 {
     return false;
 }
+inline void WidgetItem::handle_mouse_enter(MouseEvent const&) {}
+inline void WidgetItem::handle_mouse_leave(MouseEvent const&) {}
+inline void WidgetItem::handle_focus_in() {}
+inline void WidgetItem::handle_focus_out() {}
 
 /// convenience functions:
 inline bool WidgetItem::is_point_inside(int x, int y) const
@@ -162,8 +221,5 @@ inline bool WidgetItem::is_point_inside(int x, int y) const
             && m_dimensions.y <= y && y <= m_dimensions.y + m_dimensions.h);
 }
 
-inline void WidgetItem::enable() { m_enabled = true; }
-inline void WidgetItem::disable() { m_enabled = false; }
-
 
 #endif
@@ -9,6 +9,7 @@ See SDL_FontCache.hpp for license info.
   #define _CRT_SECURE_NO_WARNINGS
 #endif
 #include "SDL_FontCache.hpp"
+#include "renderstate.hpp"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -165,6 +166,16 @@ static unsigned int fc_buffer_size = 1024;
 
 static Uint8 fc_has_render_target_support = 0;
 
+// Colour of the text being drawn, set by the draw functions before rendering
+static SDL_Color fc_draw_color = {255, 255, 255, 255};
+
+// Glyphs of the text being drawn, collected into runs sharing a cache level
+static FC_Rect* fc_run_src = NULL;
+static FC_Rect* fc_run_dst = NULL;
+static int fc_run_count = 0;
+static int fc_run_capacity = 0;
+static FC_Image* fc_run_image = NULL;
+
 char* FC_GetStringASCII(void)
 {
     static char* buffer = NULL;
@@ -281,143 +292,167 @@ FC_GlyphData FC_MakeGlyphData(int cache_level, Sint16 x, Sint16 y, Uint16 w, Uin
     return gd;
 }
 
-// Enough to hold all of the ascii characters and some.
-#define FC_DEFAULT_NUM_BUCKETS 300
+// Codepoints are stored as packed UTF-8 bytes (see FC_GetCodepointFromUTF8()).
+// ASCII and Latin-1 (U+0000 to U+00FF) are looked up by index in a direct array,
+// everything else in a flat open-addressing table with linear probing.
+#define FC_MAP_DIRECT_SIZE 256
+#define FC_MAP_INITIAL_CAPACITY 64  // Must be a power of two
+#define FC_MAP_EMPTY 0xFFFFFFFFu    // Not valid UTF-8, so never a real codepoint
 
-typedef struct FC_MapNode
+typedef struct FC_MapEntry
 {
     Uint32 key;
     FC_GlyphData value;
-    struct FC_MapNode* next;
 
-} FC_MapNode;
+} FC_MapEntry;
 
 typedef struct FC_Map
 {
-    int num_buckets;
-    FC_MapNode** buckets;
+    FC_MapEntry direct[FC_MAP_DIRECT_SIZE];
+    FC_MapEntry* entries;
+    Uint32 capacity;
+    Uint32 count;  // Entries in use, excluding the direct array
 } FC_Map;
 
 
+// Returns the index of the codepoint in the direct array, or -1 if it isn't in it.
+static_inline int FC_MapDirectIndex(Uint32 codepoint)
+{
+    if(codepoint < 0x80)
+        return (int)codepoint;
+
+    // Two-byte sequences C2 80 to C3 BF encode U+0080 to U+00FF
+    if((codepoint & 0xFFFFFFC0u) == 0xC280u || (codepoint & 0xFFFFFFC0u) == 0xC380u)
+        return (int)((((codepoint >> 8) & 0x1F) << 6) | (codepoint & 0x3F));
+
+    return -1;
+}
 
-static FC_Map* FC_MapCreate(int num_buckets)
+static_inline Uint32 FC_MapHash(Uint32 codepoint)
 {
-    int i;
-    FC_Map* map = (FC_Map*)malloc(sizeof(FC_Map));
+    Uint32 hash = codepoint * 0x9E3779B1u;
+    return hash ^ (hash >> 16);
+}
 
-    map->num_buckets = num_buckets;
-    map->buckets = (FC_MapNode**)malloc(num_buckets * sizeof(FC_MapNode*));
+static FC_MapEntry* FC_MapAllocEntries(Uint32 capacity)
+{
+    Uint32 i;
+    FC_MapEntry* entries = (FC_MapEntry*)malloc(capacity * sizeof(FC_MapEntry));
+    if(entries == NULL)
+        return NULL;
 
-    for(i = 0; i < num_buckets; ++i)
-    {
-        map->buckets[i] = NULL;
-    }
+    for(i = 0; i < capacity; ++i)
+        entries[i].key = FC_MAP_EMPTY;
 
-    return map;
+    return entries;
 }
 
-/*static void FC_MapClear(FC_Map* map)
+static FC_Map* FC_MapCreate(void)
 {
     int i;
-    if(map == NULL)
-        return;
+    FC_Map* map = (FC_Map*)malloc(sizeof(FC_Map));
 
-    // Go through each bucket
-    for(i = 0; i < map->num_buckets; ++i)
+    for(i = 0; i < FC_MAP_DIRECT_SIZE; ++i)
     {
-        // Delete the nodes in order
-        FC_MapNode* node = map->buckets[i];
-        while(node != NULL)
-        {
-            FC_MapNode* last = node;
-            node = node->next;
-            free(last);
-        }
-        // Set the bucket to empty
-        map->buckets[i] = NULL;
+        map->direct[i].key = FC_MAP_EMPTY;
     }
-}*/
+
+    map->capacity = FC_MAP_INITIAL_CAPACITY;
+    map->count = 0;
+    map->entries = FC_MapAllocEntries(map->capacity);
+
+    return map;
+}
 
 static void FC_MapFree(FC_Map* map)
 {
-    int i;
     if(map == NULL)
         return;
 
-    // Go through each bucket
-    for(i = 0; i < map->num_buckets; ++i)
+    free(map->entries);
+    free(map);
+}
+
+// Returns the slot holding the codepoint, or the empty slot where it would go.
+static_inline FC_MapEntry* FC_MapProbe(FC_MapEntry* entries, Uint32 capacity, Uint32 codepoint)
+{
+    Uint32 mask = capacity - 1;
+    Uint32 index = FC_MapHash(codepoint) & mask;
+
+    // The table is never full, so this terminates
+    while(entries[index].key != codepoint && entries[index].key != FC_MAP_EMPTY)
+        index = (index + 1) & mask;
+
+    return &entries[index];
+}
+
+static Uint8 FC_MapGrow(FC_Map* map)
+{
+    Uint32 i;
+    Uint32 capacity = map->capacity * 2;
+    FC_MapEntry* entries = FC_MapAllocEntries(capacity);
+    if(entries == NULL)
+        return 0;
+
+    for(i = 0; i < map->capacity; ++i)
     {
-        // Delete the nodes in order
-        FC_MapNode* node = map->buckets[i];
-        while(node != NULL)
-        {
-            FC_MapNode* last = node;
-            node = node->next;
-            free(last);
-        }
+        if(map->entries[i].key != FC_MAP_EMPTY)
+            *FC_MapProbe(entries, capacity, map->entries[i].key) = map->entries[i];
     }
 
-    free(map->buckets);
-    free(map);
+    free(map->entries);
+    map->entries = entries;
+    map->capacity = capacity;
+    return 1;
 }
 
-// Note: Does not handle duplicates in any special way.
+// Note: Replaces the glyph of a codepoint that is already in the map.
+// The returned pointer is only valid until the next insertion.
 static FC_GlyphData* FC_MapInsert(FC_Map* map, Uint32 codepoint, FC_GlyphData glyph)
 {
-    Uint32 index;
-    FC_MapNode* node;
-    if(map == NULL)
+    FC_MapEntry* entry;
+    int direct;
+    if(map == NULL || codepoint == FC_MAP_EMPTY)
         return NULL;
 
-    // Get index for bucket
-    index = codepoint % map->num_buckets;
-
-    // If this bucket is empty, create a node and return its value
-    if(map->buckets[index] == NULL)
+    direct = FC_MapDirectIndex(codepoint);
+    if(direct >= 0)
     {
-        node = map->buckets[index] = (FC_MapNode*)malloc(sizeof(FC_MapNode));
-        node->key = codepoint;
-        node->value = glyph;
-        node->next = NULL;
-        return &node->value;
+        entry = &map->direct[direct];
     }
-
-    for(node = map->buckets[index]; node != NULL; node = node->next)
+    else
     {
-        // Find empty node and add a new one on.
-        if(node->next == NULL)
-        {
-            node->next = (FC_MapNode*)malloc(sizeof(FC_MapNode));
-            node = node->next;
+        // Keep the load factor at most 1/2, so that probe sequences stay short
+        if(map->entries == NULL || (2 * (map->count + 1) > map->capacity && !FC_MapGrow(map)))
+            return NULL;
 
-            node->key = codepoint;
-            node->value = glyph;
-            node->next = NULL;
-            return &node->value;
-        }
+        entry = FC_MapProbe(map->entries, map->capacity, codepoint);
+        if(entry->key == FC_MAP_EMPTY)
+            map->count++;
     }
 
-    return NULL;
+    entry->key = codepoint;
+    entry->value = glyph;
+    return &entry->value;
 }
 
-static FC_GlyphData* FC_MapFind(FC_Map* map, Uint32 codepoint)
+static_inline FC_GlyphData* FC_MapFind(FC_Map* map, Uint32 codepoint)
 {
-    Uint32 index;
-    FC_MapNode* node;
+    FC_MapEntry* entry;
+    int direct;
     if(map == NULL)
         return NULL;
 
-    // Get index for bucket
-    index = codepoint % map->num_buckets;
+    // Typical UI text: a single indexed load
+    direct = FC_MapDirectIndex(codepoint);
+    if(direct >= 0)
+        return map->direct[direct].key == codepoint? &map->direct[direct].value : NULL;
 
-    // Go through list until we find a match
-    for(node = map->buckets[index]; node != NULL; node = node->next)
-    {
-        if(node->key == codepoint)
-            return &node->value;
-    }
+    if(map->entries == NULL || codepoint == FC_MAP_EMPTY)
+        return NULL;
 
-    return NULL;
+    entry = FC_MapProbe(map->entries, map->capacity, codepoint);
+    return entry->key == codepoint? &entry->value : NULL;
 }
 
 
@@ -462,6 +497,10 @@ static FC_GlyphData* FC_PackGlyphData(FC_Font* font, Uint32 codepoint, Uint16 wi
 
 
 static FC_Rect FC_RenderLeft(FC_Font* font, FC_Target* dest, float x, float y, FC_Scale scale, const char* text);
+static FC_Rect FC_RenderLeftN(FC_Font* font, FC_Target* dest, float x, float y, FC_Scale scale, const char* text, size_t length);
+static void FC_AppendToRun(FC_Image* image, FC_Target* dest, FC_Rect src, FC_Rect dst);
+static void FC_FlushRun(FC_Target* dest);
+static void set_color_for_all_caches(FC_Font* font, SDL_Color color);
 static FC_Rect FC_RenderCenter(FC_Font* font, FC_Target* dest, float x, float y, FC_Scale scale, const char* text);
 static FC_Rect FC_RenderRight(FC_Font* font, FC_Target* dest, float x, float y, FC_Scale scale, const char* text);
 
@@ -729,6 +768,102 @@ void FC_SetRenderCallback(FC_Rect (*callback)(FC_Image* src, FC_Rect* srcrect, F
         fc_render_callback = callback;
 }
 
+#if !defined(FC_USE_SDL_GPU) && SDL_VERSION_ATLEAST(2,0,18)
+// Shared buffers for the default geometry callback
+static SDL_Vertex* fc_vertices = NULL;
+static int* fc_indices = NULL;
+static int fc_geometry_capacity = 0;  // In glyphs
+#endif
+
+void FC_DefaultGeometryCallback(FC_Image* src, FC_Target* dest, const FC_Rect* srcrects, const FC_Rect* dstrects, int count, SDL_Color color)
+{
+    int i;
+    if(count <= 0)
+        return;
+
+    #ifdef FC_USE_SDL_GPU
+    set_color(src, color.r, color.g, color.b, FC_GET_ALPHA(color));
+    for(i = 0; i < count; ++i)
+    {
+        FC_Rect r = srcrects[i];
+        FC_DefaultRenderCallback(src, &r, dest, dstrects[i].x, dstrects[i].y, dstrects[i].w / r.w, dstrects[i].h / r.h);
+    }
+    #elif SDL_VERSION_ATLEAST(2,0,18)
+    {
+        // The colour is carried by the vertices, so the atlas must not tint them
+        RenderState& state = RenderState::of(dest);
+        int w, h;
+        float sx, sy;
+
+        state.texture_color_mod(src, 255, 255, 255);
+        state.texture_alpha_mod(src, 255);
+
+        if(count > fc_geometry_capacity)
+        {
+            int capacity = fc_geometry_capacity? fc_geometry_capacity : 64;
+            while(capacity < count)
+                capacity *= 2;
+
+            SDL_Vertex* vertices = (SDL_Vertex*)realloc(fc_vertices, capacity * 4 * sizeof(SDL_Vertex));
+            if(vertices != NULL)
+                fc_vertices = vertices;
+            int* indices = (int*)realloc(fc_indices, capacity * 6 * sizeof(int));
+            if(indices != NULL)
+                fc_indices = indices;
+            if(vertices == NULL || indices == NULL)
+            {
+                FC_Log("SDL_FontCache: Failed to allocate vertices, so cannot draw text!\n");
+                return;
+            }
+            fc_geometry_capacity = capacity;
+        }
+
+        SDL_QueryTexture(src, NULL, NULL, &w, &h);
+        sx = w? 1.0f/w : 0;
+        sy = h? 1.0f/h : 0;
+        for(i = 0; i < count; ++i)
+        {
+            SDL_Vertex* v = &fc_vertices[4*i];
+            int* index = &fc_indices[6*i];
+            float x0 = (float)dstrects[i].x, y0 = (float)dstrects[i].y;
+            float x1 = x0 + dstrects[i].w, y1 = y0 + dstrects[i].h;
+            float u0 = srcrects[i].x * sx, v0 = srcrects[i].y * sy;
+            float u1 = (srcrects[i].x + srcrects[i].w) * sx, v1 = (srcrects[i].y + srcrects[i].h) * sy;
+
+            v[0].position.x = x0; v[0].position.y = y0; v[0].tex_coord.x = u0; v[0].tex_coord.y = v0;
+            v[1].position.x = x1; v[1].position.y = y0; v[1].tex_coord.x = u1; v[1].tex_coord.y = v0;
+            v[2].position.x = x1; v[2].position.y = y1; v[2].tex_coord.x = u1; v[2].tex_coord.y = v1;
+            v[3].position.x = x0; v[3].position.y = y1; v[3].tex_coord.x = u0; v[3].tex_coord.y = v1;
+            v[0].color = v[1].color = v[2].color = v[3].color = color;
+
+            index[0] = 4*i; index[1] = 4*i + 1; index[2] = 4*i + 2;
+            index[3] = 4*i; index[4] = 4*i + 2; index[5] = 4*i + 3;
+        }
+
+        SDL_RenderGeometry(dest, src, fc_vertices, 4*count, fc_indices, 6*count);
+    }
+    #else
+    {
+        // No geometry API: one copy per glyph, tinted through the atlas' colour mod
+        RenderState& state = RenderState::of(dest);
+        state.texture_color_mod(src, color.r, color.g, color.b);
+        state.texture_alpha_mod(src, FC_GET_ALPHA(color));
+        for(i = 0; i < count; ++i)
+            SDL_RenderCopy(dest, src, &srcrects[i], &dstrects[i]);
+    }
+    #endif
+}
+
+static void (*fc_geometry_callback)(FC_Image* src, FC_Target* dest, const FC_Rect* srcrects, const FC_Rect* dstrects, int count, SDL_Color color) = &FC_DefaultGeometryCallback;
+
+void FC_SetGeometryCallback(void (*callback)(FC_Image* src, FC_Target* dest, const FC_Rect* srcrects, const FC_Rect* dstrects, int count, SDL_Color color))
+{
+    if(callback == NULL)
+        fc_geometry_callback = &FC_DefaultGeometryCallback;
+    else
+        fc_geometry_callback = callback;
+}
+
 void FC_GetUTF8FromCodepoint(char* result, Uint32 codepoint)
 {
     char a, b, c, d;
@@ -885,7 +1020,7 @@ static void FC_Init(FC_Font* font)
     if(font->glyphs != NULL)
         FC_MapFree(font->glyphs);
 
-    font->glyphs = FC_MapCreate(FC_DEFAULT_NUM_BUCKETS);
+    font->glyphs = FC_MapCreate();
 
     font->glyph_cache_size = 3;
     font->glyph_cache_count = 0;
@@ -921,7 +1056,7 @@ static Uint8 FC_GrowGlyphCache(FC_Font* font)
         return 0;
     }
     // bug: we do not have the correct color here, this might be the wrong color!
-    //      , most functions use set_color_for_all_caches()
+    //      , text drawn glyph by glyph uses set_color_for_all_caches() (runs carry the colour per vertex)
     //   - for evading this bug, you must use FC_SetDefaultColor(), before using any draw functions
     set_color(new_level, font->default_color.r, font->default_color.g, font->default_color.b, FC_GET_ALPHA(font->default_color));
 #ifndef FC_USE_SDL_GPU
@@ -1372,7 +1507,10 @@ void FC_ResetFontFromRendererReset(FC_Font* font, SDL_Renderer* renderer, Uint32
     if (evType == SDL_RENDER_TARGETS_RESET) {
         int i;
         for (i = 0; i < font->glyph_cache_count; ++i)
+        {
+            RenderState::forget(font->glyph_cache[i]);
             SDL_DestroyTexture(font->glyph_cache[i]);
+        }
     }
     free(font->glyph_cache);
 
@@ -1411,6 +1549,7 @@ void FC_ClearFont(FC_Font* font)
         #ifdef FC_USE_SDL_GPU
         GPU_FreeImage(font->glyph_cache[i]);
         #else
+        RenderState::forget(font->glyph_cache[i]);
         SDL_DestroyTexture(font->glyph_cache[i]);
         #endif
     }
@@ -1441,6 +1580,7 @@ void FC_FreeFont(FC_Font* font)
         #ifdef FC_USE_SDL_GPU
         GPU_FreeImage(font->glyph_cache[i]);
         #else
+        RenderState::forget(font->glyph_cache[i]);
         SDL_DestroyTexture(font->glyph_cache[i]);
         #endif
     }
@@ -1537,34 +1677,39 @@ unsigned int FC_GetNumCodepoints(FC_Font* font)
 
     glyphs = font->glyphs;
 
-    for(i = 0; i < glyphs->num_buckets; ++i)
+    for(i = 0; i < FC_MAP_DIRECT_SIZE; ++i)
     {
-        FC_MapNode* node;
-        for(node = glyphs->buckets[i]; node != NULL; node = node->next)
-        {
+        if(glyphs->direct[i].key != FC_MAP_EMPTY)
             result++;
-        }
     }
 
-    return result;
+    return result + glyphs->count;
 }
 
 void FC_GetCodepoints(FC_Font* font, Uint32* result)
 {
     FC_Map* glyphs;
-    int i;
+    Uint32 i;
     unsigned int count = 0;
     if(font == NULL || font->glyphs == NULL)
         return;
 
     glyphs = font->glyphs;
 
-    for(i = 0; i < glyphs->num_buckets; ++i)
+    for(i = 0; i < FC_MAP_DIRECT_SIZE; ++i)
     {
-        FC_MapNode* node;
-        for(node = glyphs->buckets[i]; node != NULL; node = node->next)
+        if(glyphs->direct[i].key != FC_MAP_EMPTY)
         {
-            result[count] = node->key;
+            result[count] = glyphs->direct[i].key;
+            count++;
+        }
+    }
+
+    for(i = 0; i < glyphs->capacity; ++i)
+    {
+        if(glyphs->entries[i].key != FC_MAP_EMPTY)
+        {
+            result[count] = glyphs->entries[i].key;
             count++;
         }
     }
@@ -1640,11 +1785,278 @@ FC_GlyphData* FC_SetGlyphData(FC_Font* font, Uint32 codepoint, FC_GlyphData glyp
 }
 
 
+// Glyph sets
+
+struct FC_GlyphSet
+{
+    int count;
+    Uint32* codepoints;
+    SDL_Surface** surfaces;
+};
+
+FC_GlyphSet* FC_RasterizeGlyphs(TTF_Font* ttf, const char* charset)
+{
+    SDL_Color white = {255, 255, 255, 255};
+    FC_GlyphSet* set;
+    SDL_Surface* surf;
+    char buff[5];
+    const char* buff_ptr;
+    const char* c;
+    int length;
+
+    if(ttf == NULL || charset == NULL)
+        return NULL;
+
+    length = U8_strlen(charset);
+    set = (FC_GlyphSet*)malloc(sizeof(FC_GlyphSet));
+    if(set == NULL)
+        return NULL;
+    set->count = 0;
+    set->codepoints = (Uint32*)malloc((length + 1) * sizeof(Uint32));
+    set->surfaces = (SDL_Surface**)malloc((length + 1) * sizeof(SDL_Surface*));
+    if(set->codepoints == NULL || set->surfaces == NULL)
+    {
+        FC_FreeGlyphSet(set);
+        return NULL;
+    }
+
+    for(c = charset; *c != '\0'; c = U8_next(c))
+    {
+        memset(buff, 0, 5);
+        if(!U8_charcpy(buff, c, 5))
+            continue;
+        surf = TTF_RenderUTF8_Blended(ttf, buff, white);
+        if(surf == NULL)
+            continue;
+
+        buff_ptr = buff;
+        set->codepoints[set->count] = FC_GetCodepointFromUTF8(&buff_ptr, 0);
+        set->surfaces[set->count] = surf;
+        set->count++;
+    }
+
+    return set;
+}
+
+void FC_FreeGlyphSet(FC_GlyphSet* set)
+{
+    int i;
+    if(set == NULL)
+        return;
+
+    for(i = 0; i < set->count; ++i)
+        SDL_FreeSurface(set->surfaces[i]);
+    free(set->surfaces);
+    free(set->codepoints);
+    free(set);
+}
+
+// Copies the staged glyphs onto a cache level: a new level is uploaded whole, an existing one gets the glyph rects drawn from a single texture
+static Uint8 FC_UploadStagedGlyphs(FC_Font* font, int cache_level, Uint8 new_level, SDL_Surface* staging, FC_Rect* rects, int num_rects)
+{
+    int i;
+    FC_Image* dest;
+
+    if(new_level)
+    {
+        if(!FC_UploadGlyphCache(font, cache_level, staging))
+            return 0;
+        #ifndef FC_USE_SDL_GPU
+        SDL_SetTextureBlendMode(font->glyph_cache[cache_level], SDL_BLENDMODE_BLEND);
+        #endif
+        return 1;
+    }
+
+    if(num_rects == 0)
+        return 1;
+
+    dest = FC_GetGlyphCacheLevel(font, cache_level);
+    if(dest == NULL)
+        return 0;
+
+    #ifdef FC_USE_SDL_GPU
+    {
+        GPU_Target* target = GPU_LoadTarget(dest);
+        if(target == NULL)
+            return 0;
+        GPU_Image* img = GPU_CopyImageFromSurface(staging);
+        GPU_SetAnchor(img, 0.5f, 0.5f);  // Just in case the default is different
+        GPU_SetImageFilter(img, GPU_FILTER_NEAREST);
+        GPU_SetBlendMode(img, GPU_BLEND_SET);
+
+        for(i = 0; i < num_rects; ++i)
+            GPU_Blit(img, &rects[i], target, rects[i].x + rects[i].w/2, rects[i].y + rects[i].h/2);
+
+        GPU_FreeImage(img);
+        GPU_FreeTarget(target);
+    }
+    #else
+    {
+        SDL_Renderer* renderer = font->renderer;
+        SDL_Texture* img;
+        SDL_Texture* prev_target = SDL_GetRenderTarget(renderer);
+        SDL_Rect prev_clip, prev_viewport;
+        int prev_logicalw, prev_logicalh;
+        Uint8 prev_clip_enabled;
+        float prev_scalex, prev_scaley;
+
+        img = SDL_CreateTextureFromSurface(renderer, staging);
+        if(img == NULL)
+            return 0;
+        SDL_SetTextureBlendMode(img, SDL_BLENDMODE_NONE);
+
+        // only backup if previous target existed (SDL will preserve them for the default target)
+        if (prev_target) {
+            prev_clip_enabled = has_clip(renderer);
+            if (prev_clip_enabled)
+                prev_clip = get_clip(renderer);
+            SDL_RenderGetViewport(renderer, &prev_viewport);
+            SDL_RenderGetScale(renderer, &prev_scalex, &prev_scaley);
+            SDL_RenderGetLogicalSize(renderer, &prev_logicalw, &prev_logicalh);
+        }
+
+        // Only the glyph rects: the rest of the level already holds other glyphs
+        SDL_SetRenderTarget(renderer, dest);
+        for(i = 0; i < num_rects; ++i)
+            SDL_RenderCopy(renderer, img, &rects[i], &rects[i]);
+        SDL_SetRenderTarget(renderer, prev_target);
+        if (prev_target) {
+            if (prev_clip_enabled)
+                set_clip(renderer, &prev_clip);
+            if (prev_logicalw && prev_logicalh)
+                SDL_RenderSetLogicalSize(renderer, prev_logicalw, prev_logicalh);
+            else {
+                SDL_RenderSetViewport(renderer, &prev_viewport);
+                SDL_RenderSetScale(renderer, prev_scalex, prev_scaley);
+            }
+        }
+
+        SDL_DestroyTexture(img);
+    }
+    #endif
+
+    return 1;
+}
+
+Uint8 FC_AddGlyphSet(FC_Font* font, FC_GlyphSet* set)
+{
+    int i, w, h;
+    int cache_level;
+    int num_rects = 0;
+    Uint8 new_level = 0;
+    Uint8 result = 1;
+    FC_Image* cache_image;
+    SDL_Surface* staging;
+    FC_Rect* rects;
+
+    if(font == NULL || set == NULL)
+        return 0;
+
+    // Glyphs can only be added to an existing level by rendering to it
+    cache_level = font->last_glyph.cache_level;
+    cache_image = FC_GetGlyphCacheLevel(font, cache_level);
+    if(cache_image == NULL || !fc_has_render_target_support)
+    {
+        cache_level = font->glyph_cache_count;
+        font->last_glyph.cache_level = cache_level;
+        font->last_glyph.rect.x = FC_CACHE_PADDING;
+        font->last_glyph.rect.y = FC_CACHE_PADDING;
+        font->last_glyph.rect.w = 0;
+        new_level = 1;
+        w = font->height * 12;
+        h = font->height * 12;
+    }
+    else
+    {
+        #ifdef FC_USE_SDL_GPU
+        w = cache_image->w;
+        h = cache_image->h;
+        #else
+        SDL_QueryTexture(cache_image, NULL, NULL, &w, &h);
+        #endif
+    }
+
+    staging = FC_CreateSurface32(w, h);
+    rects = (FC_Rect*)malloc((set->count + 1) * sizeof(FC_Rect));
+    if(staging == NULL || rects == NULL)
+    {
+        SDL_FreeSurface(staging);
+        free(rects);
+        return 0;
+    }
+
+    for(i = 0; i < set->count; ++i)
+    {
+        SDL_Surface* glyph_surf = set->surfaces[i];
+        FC_GlyphData* e;
+
+        // Skip glyphs which were cached meanwhile (e.g. drawn lazily)
+        if(FC_MapFind(font->glyphs, set->codepoints[i]) != NULL)
+            continue;
+
+        e = FC_PackGlyphData(font, set->codepoints[i], glyph_surf->w, staging->w, staging->h);
+        if(e == NULL)
+        {
+            // This level is full: upload it and stage the next one
+            if(!FC_UploadStagedGlyphs(font, cache_level, new_level, staging, rects, num_rects))
+            {
+                result = 0;
+                break;
+            }
+            SDL_FreeSurface(staging);
+            num_rects = 0;
+            new_level = 1;
+            cache_level = font->glyph_cache_count;
+            font->last_glyph.cache_level = cache_level;
+
+            staging = FC_CreateSurface32(font->height * 12, font->height * 12);
+            if(staging == NULL)
+            {
+                result = 0;
+                break;
+            }
+
+            e = FC_PackGlyphData(font, set->codepoints[i], glyph_surf->w, staging->w, staging->h);
+            if(e == NULL)
+                continue;  // Does not fit on an empty level either
+        }
+
+        {
+            SDL_Rect srcRect = {0, 0, glyph_surf->w, glyph_surf->h};
+            SDL_Rect destrect = e->rect;
+            SDL_SetSurfaceBlendMode(glyph_surf, SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(glyph_surf, &srcRect, staging, &destrect);
+            rects[num_rects++] = e->rect;
+        }
+    }
+
+    // New levels are uploaded even if empty, as the packing cursor already points at them
+    if(staging != NULL)
+    {
+        if(result && !FC_UploadStagedGlyphs(font, cache_level, new_level, staging, rects, num_rects))
+            result = 0;
+        SDL_FreeSurface(staging);
+    }
+    free(rects);
+
+    if(!result)
+        FC_Log("SDL_FontCache error: Could not upload all of the rasterized glyphs!\n");
+    return result;
+}
+
+
 
 // Drawing
 static FC_Rect FC_RenderLeft(FC_Font* font, FC_Target* dest, float x, float y, FC_Scale scale, const char* text)
+{
+    return FC_RenderLeftN(font, dest, x, y, scale, text, text == NULL? 0 : strlen(text));
+}
+
+// Renders 'length' bytes of 'text', which need not be null-terminated
+static FC_Rect FC_RenderLeftN(FC_Font* font, FC_Target* dest, float x, float y, FC_Scale scale, const char* text, size_t length)
 {
     const char* c = text;
+    const char* end = text + length;
     FC_Rect srcRect;
     FC_Rect dstRect;
     FC_Rect dirtyRect = FC_MakeRect(x, y, 0, 0);
@@ -1668,9 +2080,19 @@ static FC_Rect FC_RenderLeft(FC_Font* font, FC_Target* dest, float x, float y, F
     if(c == NULL || font->glyph_cache_count == 0 || dest == NULL)
         return dirtyRect;
 
+    // Draw unflipped glyphs in runs, unless they must go through a custom render callback (one installed without a geometry callback)
+    #ifdef FC_USE_SDL_GPU
+    Uint8 use_runs = 0;
+    #else
+    Uint8 use_runs = (scale.x > 0 && scale.y > 0
+                      && (fc_render_callback == &FC_DefaultRenderCallback || fc_geometry_callback != &FC_DefaultGeometryCallback));
+    #endif
+    if(!use_runs)
+        set_color_for_all_caches(font, fc_draw_color);
+
     int newlineX = x;
 
-    for(; *c != '\0'; c++)
+    for(; c < end; c++)
     {
         if(*c == '\n')
         {
@@ -1679,7 +2101,16 @@ static FC_Rect FC_RenderLeft(FC_Font* font, FC_Target* dest, float x, float y, F
             continue;
         }
 
-        codepoint = FC_GetCodepointFromUTF8(&c, 1);  // Increments 'c' to skip the extra UTF-8 bytes
+        if((unsigned char)*c < 0x80)
+        {
+            codepoint = (unsigned char)*c;  // ASCII: no decoding needed
+        }
+        else
+        {
+            if(c + U8_charsize(c) > end)
+                break;  // Truncated UTF-8 sequence
+            codepoint = FC_GetCodepointFromUTF8(&c, 1);  // Increments 'c' to skip the extra UTF-8 bytes
+        }
         if(!FC_GetGlyphData(font, &glyph, codepoint))
         {
             codepoint = ' ';
@@ -1705,7 +2136,13 @@ static FC_Rect FC_RenderLeft(FC_Font* font, FC_Target* dest, float x, float y, F
         #else
         srcRect = glyph.rect;
         #endif
-        dstRect = fc_render_callback(FC_GetGlyphCacheLevel(font, glyph.cache_level), &srcRect, dest, destX, destY, scale.x, scale.y);
+        if(use_runs)
+        {
+            dstRect = FC_MakeRect((int)destX, (int)destY, (int)(srcRect.w*scale.x), (int)(srcRect.h*scale.y));
+            FC_AppendToRun(FC_GetGlyphCacheLevel(font, glyph.cache_level), dest, srcRect, dstRect);
+        }
+        else
+            dstRect = fc_render_callback(FC_GetGlyphCacheLevel(font, glyph.cache_level), &srcRect, dest, destX, destY, scale.x, scale.y);
         if(dirtyRect.w == 0 || dirtyRect.h == 0)
             dirtyRect = dstRect;
         else
@@ -1714,19 +2151,78 @@ static FC_Rect FC_RenderLeft(FC_Font* font, FC_Target* dest, float x, float y, F
         destX += glyph.rect.w*scale.x + destLetterSpacing;
     }
 
+    if(use_runs)
+        FC_FlushRun(dest);
+
     return dirtyRect;
 }
 
+static void FC_FlushRun(FC_Target* dest)
+{
+    if(fc_run_count > 0)
+        fc_geometry_callback(fc_run_image, dest, fc_run_src, fc_run_dst, fc_run_count, fc_draw_color);
+    fc_run_count = 0;
+    fc_run_image = NULL;
+}
+
+static void FC_AppendToRun(FC_Image* image, FC_Target* dest, FC_Rect src, FC_Rect dst)
+{
+    if(image != fc_run_image)
+    {
+        FC_FlushRun(dest);
+        fc_run_image = image;
+    }
+
+    if(fc_run_count == fc_run_capacity)
+    {
+        int capacity = fc_run_capacity? 2*fc_run_capacity : 64;
+        FC_Rect* run_src = (FC_Rect*)realloc(fc_run_src, capacity * sizeof(FC_Rect));
+        if(run_src != NULL)
+            fc_run_src = run_src;
+        FC_Rect* run_dst = (FC_Rect*)realloc(fc_run_dst, capacity * sizeof(FC_Rect));
+        if(run_dst != NULL)
+            fc_run_dst = run_dst;
+        if(run_src == NULL || run_dst == NULL)
+        {
+            // Draw what we have, and try again with an empty run
+            FC_FlushRun(dest);
+            fc_run_image = image;
+            if(fc_run_capacity == 0)
+                return;
+        }
+        else
+            fc_run_capacity = capacity;
+    }
+
+    fc_run_src[fc_run_count] = src;
+    fc_run_dst[fc_run_count] = dst;
+    fc_run_count++;
+}
+
+static void set_draw_color(SDL_Color color)
+{
+    fc_draw_color = color;
+}
+
 static void set_color_for_all_caches(FC_Font* font, SDL_Color color)
 {
     // TODO: How can I predict which glyph caches are to be used?
     FC_Image* img;
     int i;
     int num_levels = FC_GetNumCacheLevels(font);
+    #ifndef FC_USE_SDL_GPU
+    // this runs before every draw, usually with the same colour: skip atlases that already have it
+    RenderState& state = RenderState::of(font->renderer);
+    #endif
     for(i = 0; i < num_levels; ++i)
     {
         img = FC_GetGlyphCacheLevel(font, i);
+        #ifdef FC_USE_SDL_GPU
         set_color(img, color.r, color.g, color.b, FC_GET_ALPHA(color));
+        #else
+        state.texture_color_mod(img, color.r, color.g, color.b);
+        state.texture_alpha_mod(img, FC_GET_ALPHA(color));
+        #endif
     }
 }
 
@@ -1737,11 +2233,21 @@ FC_Rect FC_Draw(FC_Font* font, FC_Target* dest, float x, float y, const char* fo
 
     FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
 
-    set_color_for_all_caches(font, font->default_color);
+    set_draw_color(font->default_color);
 
     return FC_RenderLeft(font, dest, x, y, FC_MakeScale(1,1), fc_buffer);
 }
 
+FC_Rect FC_DrawText(FC_Font* font, FC_Target* dest, float x, float y, const char* text, size_t length)
+{
+    if(text == NULL || font == NULL)
+        return FC_MakeRect(x, y, 0, 0);
+
+    set_draw_color(font->default_color);
+
+    return FC_RenderLeftN(font, dest, x, y, FC_MakeScale(1,1), text, length);
+}
+
 
 
 typedef struct FC_StringList
@@ -1980,7 +2486,7 @@ FC_Rect FC_DrawBox(FC_Font* font, FC_Target* dest, FC_Rect box, const char* form
 
     set_clip(dest, &newclip);
 
-    set_color_for_all_caches(font, font->default_color);
+    set_draw_color(font->default_color);
 
     FC_DrawColumnFromBuffer(font, dest, box, NULL, FC_MakeScale(1,1), FC_ALIGN_LEFT);
 
@@ -2011,7 +2517,7 @@ FC_Rect FC_DrawBoxAlign(FC_Font* font, FC_Target* dest, FC_Rect box, FC_AlignEnu
         newclip = box;
     set_clip(dest, &newclip);
 
-    set_color_for_all_caches(font, font->default_color);
+    set_draw_color(font->default_color);
 
     FC_DrawColumnFromBuffer(font, dest, box, NULL, FC_MakeScale(1,1), align);
 
@@ -2042,7 +2548,7 @@ FC_Rect FC_DrawBoxScale(FC_Font* font, FC_Target* dest, FC_Rect box, FC_Scale sc
         newclip = box;
     set_clip(dest, &newclip);
 
-    set_color_for_all_caches(font, font->default_color);
+    set_draw_color(font->default_color);
 
     FC_DrawColumnFromBuffer(font, dest, box, NULL, scale, FC_ALIGN_LEFT);
 
@@ -2073,7 +2579,7 @@ FC_Rect FC_DrawBoxColor(FC_Font* font, FC_Target* dest, FC_Rect box, SDL_Color c
         newclip = box;
     set_clip(dest, &newclip);
 
-    set_color_for_all_caches(font, color);
+    set_draw_color(color);
 
     FC_DrawColumnFromBuffer(font, dest, box, NULL, FC_MakeScale(1,1), FC_ALIGN_LEFT);
 
@@ -2104,7 +2610,7 @@ FC_Rect FC_DrawBoxEffect(FC_Font* font, FC_Target* dest, FC_Rect box, FC_Effect
         newclip = box;
     set_clip(dest, &newclip);
 
-    set_color_for_all_caches(font, effect.color);
+    set_draw_color(effect.color);
 
     FC_DrawColumnFromBuffer(font, dest, box, NULL, effect.scale, effect.alignment);
 
@@ -2131,7 +2637,7 @@ FC_Rect FC_DrawColumn(FC_Font* font, FC_Target* dest, float x, float y, Uint16 w
 
     FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
 
-    set_color_for_all_caches(font, font->default_color);
+    set_draw_color(font->default_color);
 
     FC_DrawColumnFromBuffer(font, dest, box, &total_height, FC_MakeScale(1,1), FC_ALIGN_LEFT);
 
@@ -2152,7 +2658,7 @@ FC_Rect FC_DrawColumnAlign(FC_Font* font, FC_Target* dest, float x, float y, Uin
 
     FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
 
-    set_color_for_all_caches(font, font->default_color);
+    set_draw_color(font->default_color);
 
     switch(align)
     {
@@ -2184,7 +2690,7 @@ FC_Rect FC_DrawColumnScale(FC_Font* font, FC_Target* dest, float x, float y, Uin
 
     FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
 
-    set_color_for_all_caches(font, font->default_color);
+    set_draw_color(font->default_color);
 
     FC_DrawColumnFromBuffer(font, dest, box, &total_height, scale, FC_ALIGN_LEFT);
 
@@ -2204,7 +2710,7 @@ FC_Rect FC_DrawColumnColor(FC_Font* font, FC_Target* dest, float x, float y, Uin
 
     FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
 
-    set_color_for_all_caches(font, color);
+    set_draw_color(color);
 
     FC_DrawColumnFromBuffer(font, dest, box, &total_height, FC_MakeScale(1,1), FC_ALIGN_LEFT);
 
@@ -2226,7 +2732,7 @@ FC_Rect FC_DrawColumnEffect(FC_Font* font, FC_Target* dest, float x, float y, Ui
 
     FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
 
-    set_color_for_all_caches(font, effect.color);
+    set_draw_color(effect.color);
 
     switch(effect.alignment)
     {
@@ -2321,7 +2827,7 @@ FC_Rect FC_DrawScale(FC_Font* font, FC_Target* dest, float x, float y, FC_Scale
 
     FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
 
-    set_color_for_all_caches(font, font->default_color);
+    set_draw_color(font->default_color);
 
     return FC_RenderLeft(font, dest, x, y, scale, fc_buffer);
 }
@@ -2333,7 +2839,7 @@ FC_Rect FC_DrawAlign(FC_Font* font, FC_Target* dest, float x, float y, FC_AlignE
 
     FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
 
-    set_color_for_all_caches(font, font->default_color);
+    set_draw_color(font->default_color);
 
     FC_Rect result;
     switch(align)
@@ -2362,7 +2868,7 @@ FC_Rect FC_DrawColor(FC_Font* font, FC_Target* dest, float x, float y, SDL_Color
 
     FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
 
-    set_color_for_all_caches(font, color);
+    set_draw_color(color);
 
     return FC_RenderLeft(font, dest, x, y, FC_MakeScale(1,1), fc_buffer);
 }
@@ -2375,7 +2881,7 @@ FC_Rect FC_DrawEffect(FC_Font* font, FC_Target* dest, float x, float y, FC_Effec
 
     FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
 
-    set_color_for_all_caches(font, effect.color);
+    set_draw_color(effect.color);
 
     FC_Rect result;
     switch(effect.alignment)
@@ -2419,17 +2925,13 @@ Uint16 FC_GetLineHeight(FC_Font* font)
     return font->height;
 }
 
-Uint16 FC_GetHeight(FC_Font* font, const char* formatted_text, ...)
+static Uint16 FC_GetHeightN(FC_Font* font, const char* text, size_t length)
 {
-    if(formatted_text == NULL || font == NULL)
-        return 0;
-
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
-
     Uint16 numLines = 1;
     const char* c;
+    const char* end = text + length;
 
-    for (c = fc_buffer; *c != '\0'; c++)
+    for (c = text; c < end; c++)
     {
         if(*c == '\n')
             numLines++;
@@ -2439,18 +2941,14 @@ Uint16 FC_GetHeight(FC_Font* font, const char* formatted_text, ...)
     return font->height*numLines + font->lineSpacing*(numLines - 1);  //height*numLines;
 }
 
-Uint16 FC_GetWidth(FC_Font* font, const char* formatted_text, ...)
+static Uint16 FC_GetWidthN(FC_Font* font, const char* text, size_t length)
 {
-    if(formatted_text == NULL || font == NULL)
-        return 0;
-
-    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
-
     const char* c;
+    const char* end = text + length;
     Uint16 width = 0;
     Uint16 bigWidth = 0;  // Allows for multi-line strings
 
-    for (c = fc_buffer; *c != '\0'; c++)
+    for (c = text; c < end; c++)
     {
         if(*c == '\n')
         {
@@ -2459,8 +2957,19 @@ Uint16 FC_GetWidth(FC_Font* font, const char* formatted_text, ...)
             continue;
         }
 
+        Uint32 codepoint;
+        if((unsigned char)*c < 0x80)
+        {
+            codepoint = (unsigned char)*c;  // ASCII: no decoding needed
+        }
+        else
+        {
+            if(c + U8_charsize(c) > end)
+                break;  // Truncated UTF-8 sequence
+            codepoint = FC_GetCodepointFromUTF8(&c, 1);
+        }
+
         FC_GlyphData glyph;
-        Uint32 codepoint = FC_GetCodepointFromUTF8(&c, 1);
         if(FC_GetGlyphData(font, &glyph, codepoint) || FC_GetGlyphData(font, &glyph, ' '))
             width += glyph.rect.w;
     }
@@ -2469,6 +2978,34 @@ Uint16 FC_GetWidth(FC_Font* font, const char* formatted_text, ...)
     return bigWidth;
 }
 
+Uint16 FC_GetHeight(FC_Font* font, const char* formatted_text, ...)
+{
+    if(formatted_text == NULL || font == NULL)
+        return 0;
+
+    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+
+    return FC_GetHeightN(font, fc_buffer, strlen(fc_buffer));
+}
+
+Uint16 FC_GetWidth(FC_Font* font, const char* formatted_text, ...)
+{
+    if(formatted_text == NULL || font == NULL)
+        return 0;
+
+    FC_EXTRACT_VARARGS(fc_buffer, formatted_text);
+
+    return FC_GetWidthN(font, fc_buffer, strlen(fc_buffer));
+}
+
+FC_Rect FC_MeasureText(FC_Font* font, const char* text, size_t length)
+{
+    if(text == NULL || font == NULL)
+        return FC_MakeRect(0, 0, 0, 0);
+
+    return FC_MakeRect(0, 0, FC_GetWidthN(font, text, length), FC_GetHeightN(font, text, length));
+}
+
 // If width == -1, use no width limit
 FC_Rect FC_GetCharacterOffset(FC_Font* font, Uint16 position_index, int column_width, const char* formatted_text, ...)
 {
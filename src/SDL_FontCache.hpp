@@ -100,6 +100,9 @@ typedef struct FC_Effect
 // Opaque type
 typedef struct FC_Font FC_Font;
 
+// Glyphs rasterized ahead of time, see FC_RasterizeGlyphs()
+typedef struct FC_GlyphSet FC_GlyphSet;
+
 
 typedef struct FC_GlyphData
 {
@@ -225,6 +228,14 @@ void FC_SetRenderCallback(FC_Rect (*callback)(FC_Image* src, FC_Rect* srcrect, F
 
 FC_Rect FC_DefaultRenderCallback(FC_Image* src, FC_Rect* srcrect, FC_Target* dest, float x, float y, float xscale, float yscale);
 
+/*! Sets the function used to draw a run of glyphs from the same cache level, in the given colour.
+ * Runs are used for text which is not flipped, unless a custom render callback is installed and the geometry callback is the default one;
+ * otherwise glyphs are drawn one by one through the render callback.  Passing NULL restores the default. */
+void FC_SetGeometryCallback(void (*callback)(FC_Image* src, FC_Target* dest, const FC_Rect* srcrects, const FC_Rect* dstrects, int count, SDL_Color color));
+
+/*! Draws a run of glyphs with a single SDL_RenderGeometry() call, the colour carried per vertex (one copy per glyph before SDL 2.0.18). */
+void FC_DefaultGeometryCallback(FC_Image* src, FC_Target* dest, const FC_Rect* srcrects, const FC_Rect* dstrects, int count, SDL_Color color);
+
 
 // Custom caching
 
@@ -241,6 +252,15 @@ Uint8 FC_SetGlyphCacheLevel(FC_Font* font, int cache_level, FC_Image* cache_text
 /*! Copies the given surface to the given cache level as a texture.  New cache levels must be sequential. */
 Uint8 FC_UploadGlyphCache(FC_Font* font, int cache_level, SDL_Surface* data_surface);
 
+/*! Rasterizes the glyphs of the given UTF-8 string into surfaces.  Only 'ttf' is used, no FC_Font or renderer, so this may run on another thread as long as nothing else uses 'ttf' meanwhile.  Returns NULL on failure. */
+FC_GlyphSet* FC_RasterizeGlyphs(TTF_Font* ttf, const char* charset);
+
+/*! Packs the rasterized glyphs which the font has not cached yet into its cache levels, uploading each level it touches once.  The glyphs must have been rasterized with the font's TTF source (or an identical copy of it).  Must be called on the rendering thread. */
+Uint8 FC_AddGlyphSet(FC_Font* font, FC_GlyphSet* set);
+
+/*! Frees the surfaces of a glyph set. */
+void FC_FreeGlyphSet(FC_GlyphSet* set);
+
 
 /*! Returns the number of codepoints that are stored in the font's glyph data map. */
 unsigned int FC_GetNumCodepoints(FC_Font* font);
@@ -275,6 +295,9 @@ FC_Rect FC_DrawColumnScale(FC_Font* font, FC_Target* dest, float x, float y, Uin
 FC_Rect FC_DrawColumnColor(FC_Font* font, FC_Target* dest, float x, float y, Uint16 width, SDL_Color color, const char* formatted_text, ...);
 FC_Rect FC_DrawColumnEffect(FC_Font* font, FC_Target* dest, float x, float y, Uint16 width, FC_Effect effect, const char* formatted_text, ...);
 
+/*! Draws 'length' bytes of 'text' as is: the text is not treated as a format string (so it isn't copied or truncated to the buffer size), and need not be null-terminated. */
+FC_Rect FC_DrawText(FC_Font* font, FC_Target* dest, float x, float y, const char* text, size_t length);
+
 
 // Getters
 
@@ -283,6 +306,9 @@ Uint16 FC_GetLineHeight(FC_Font* font);
 Uint16 FC_GetHeight(FC_Font* font, const char* formatted_text, ...);
 Uint16 FC_GetWidth(FC_Font* font, const char* formatted_text, ...);
 
+/*! Returns the width and height of 'length' bytes of 'text', which is not treated as a format string (see FC_DrawText()). */
+FC_Rect FC_MeasureText(FC_Font* font, const char* text, size_t length);
+
 // Returns a 1-pixel wide box in front of the character in the given position (index)
 FC_Rect FC_GetCharacterOffset(FC_Font* font, Uint16 position_index, int column_width, const char* formatted_text, ...);
 Uint16 FC_GetColumnHeight(FC_Font* font, Uint16 width, const char* formatted_text, ...);
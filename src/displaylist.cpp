@@ -0,0 +1,221 @@
+/*
+ *      Copyright (C) 2020 Johnathan Law
+ *
+ *      This file is part of SWL.
+ *
+ *      SWL is free software: you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation, either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      SWL is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with SWL.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "displaylist.hpp"
+#include "renderbatch.hpp"
+#include "renderstate.hpp"
+
+#include <cassert>
+
+
+DisplayList* DisplayList::s_recording = nullptr;
+
+
+/// constructors:
+DisplayList::DisplayList() noexcept
+    : m_garbage{0}
+    , m_current{0}
+    , m_run{0}
+    , m_volatile{false}
+    , m_previous{nullptr}
+{
+}
+
+/// destructor:
+DisplayList::~DisplayList()
+{
+    if (s_recording == this)
+        end();
+}
+
+/// modifiers:
+void DisplayList::begin(std::size_t index)
+{
+    assert(s_recording != this && "begin() called twice without end()");
+    
+    if (index >= m_slices.size())
+        m_slices.resize(index + 1, Slice{0, 0, EMPTY});
+    discard(index);
+    
+    m_slices[index] = Slice{m_commands.size(), 0, EMPTY};
+    m_current = index;
+    m_run = m_commands.size();
+    m_volatile = false;
+    
+    //  lists may nest (e.g. a canvas rendering another canvas' children), so remember the outer one
+    m_previous = s_recording;
+    s_recording = this;
+}
+
+void DisplayList::end()
+{
+    assert(s_recording == this && "end() called without begin()");
+    
+    s_recording = m_previous;
+    
+    auto& slice = m_slices[m_current];
+    slice.count = m_commands.size() - slice.offset;
+    slice.state = RECORDED;
+    if (m_volatile)
+    {
+        //  keep the commands out of the way, the child will be rendered directly from now on
+        discard(m_current);
+        slice.state = VOLATILE;
+    }
+    
+    compact();
+}
+
+void DisplayList::invalidate(std::size_t index)
+{
+    if (index >= m_slices.size())
+        return;
+    
+    discard(index);
+    m_slices[index].state = EMPTY;
+}
+
+void DisplayList::clear()
+{
+    m_commands.clear();
+    m_slices.clear();
+    m_garbage = 0;
+}
+
+/// recording functions:
+void DisplayList::fill_rect(SDL_Rect const& rect, SDL_Color const& color)
+{
+    push(Command{FILL_RECT, 0, color, nullptr, {0, 0, 0, 0}, rect});
+}
+
+void DisplayList::outline_rect(SDL_Rect const& rect, SDL_Color const& color)
+{
+    push(Command{OUTLINE_RECT, 0, color, nullptr, {0, 0, 0, 0}, rect});
+}
+
+void DisplayList::copy(SDL_Texture* texture, SDL_Rect const* src, SDL_Rect const& dst)
+{
+    push(Command{COPY, 0, {0, 0, 0, 0}, texture, src ? *src : SDL_Rect{0, 0, 0, 0}, dst});
+}
+
+void DisplayList::glyph(SDL_Texture* atlas, SDL_Rect const& src, SDL_Rect const& dst, SDL_Color const& color)
+{
+    const bool same_run = m_run < m_commands.size() && m_commands[m_run].texture == atlas
+                          && m_commands[m_run].color.r == color.r && m_commands[m_run].color.g == color.g
+                          && m_commands[m_run].color.b == color.b && m_commands[m_run].color.a == color.a;
+    if (!same_run)
+    {
+        push(Command{GLYPH_RUN, 0, color, atlas, {0, 0, 0, 0}, {0, 0, 0, 0}});
+        m_run = m_commands.size() - 1;
+    }
+    
+    m_commands.push_back(Command{GLYPH, 0, color, atlas, src, dst});
+    ++m_commands[m_run].count;
+}
+
+void DisplayList::mark_volatile()
+{
+    m_volatile = true;
+}
+
+/// accessors:
+void DisplayList::replay(Renderer const& renderer, std::size_t index) const
+{
+    assert(is_recorded(index));
+    
+    auto r = renderer.get();
+    auto& state = RenderState::of(r);
+    auto const& slice = m_slices[index];
+    const auto last = slice.offset + slice.count;
+    
+    if (auto batch = RenderBatch::active())
+    {
+        for (auto i = slice.offset; i < last; ++i)
+        {
+            auto const& command = m_commands[i];
+            switch (command.kind)
+            {
+            case FILL_RECT:     batch->fill_rect(command.dst, command.color); break;
+            case OUTLINE_RECT:  batch->outline_rect(command.dst, command.color); break;
+            case COPY:          batch->copy(command.texture, command.src.w ? &command.src : nullptr, command.dst); break;
+            case GLYPH_RUN:     break;
+            case GLYPH:         batch->copy(command.texture, &command.src, command.dst, command.color); break;
+            }
+        }
+        return;
+    }
+    
+    for (auto i = slice.offset; i < last; ++i)
+    {
+        auto const& command = m_commands[i];
+        switch (command.kind)
+        {
+        case FILL_RECT:
+            state.draw_color(command.color);
+            SDL_RenderFillRect(r, &command.dst);
+            break;
+        case OUTLINE_RECT:
+            state.draw_color(command.color);
+            SDL_RenderDrawRect(r, &command.dst);
+            break;
+        case COPY:
+            SDL_RenderCopy(r, command.texture, command.src.w ? &command.src : nullptr, &command.dst);
+            break;
+        case GLYPH_RUN:
+            state.texture_color_mod(command.texture, command.color.r, command.color.g, command.color.b);
+            state.texture_alpha_mod(command.texture, command.color.a);
+            break;
+        case GLYPH:
+            SDL_RenderCopy(r, command.texture, &command.src, &command.dst);
+            break;
+        }
+    }
+}
+
+/// helper functions:
+void DisplayList::push(Command const& command)
+{
+    m_run = m_commands.size() + 1;  //  any other command ends the glyph run
+    m_commands.push_back(command);
+}
+
+void DisplayList::discard(std::size_t index)
+{
+    auto& slice = m_slices[index];
+    m_garbage += slice.count;
+    slice.count = 0;
+}
+
+void DisplayList::compact()
+{
+    if (m_garbage * 2 <= m_commands.size())
+        return;
+    
+    std::vector<Command> commands;
+    commands.reserve(m_commands.size() - m_garbage);
+    for (auto& slice : m_slices)
+    {
+        const auto offset = commands.size();
+        commands.insert(commands.end(), m_commands.begin() + slice.offset, m_commands.begin() + slice.offset + slice.count);
+        slice.offset = offset;
+    }
+    m_commands.swap(commands);
+    m_garbage = 0;
+}
@@ -0,0 +1,129 @@
+/*
+ *      Copyright (C) 2020 Johnathan Law
+ *
+ *      This file is part of SWL.
+ *
+ *      SWL is free software: you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation, either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      SWL is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with SWL.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "framescheduler.hpp"
+
+
+/// constructors:
+FrameScheduler::FrameScheduler(unsigned frame_rate, unsigned update_rate) noexcept
+    : m_frequency{SDL_GetPerformanceFrequency()}
+    , m_last_time{0}
+    , m_next_frame{0}
+    , m_accumulator{0}
+    , m_updates{0}
+    , m_vsync{false}
+    , m_started{false}
+{
+    this->frame_rate(frame_rate);
+    this->update_rate(update_rate);
+}
+
+/// modifiers:
+void FrameScheduler::frame_rate(unsigned fps)
+{
+    m_frame_rate = fps;
+    m_frame_ticks = fps ? m_frequency / fps : 0;
+}
+
+void FrameScheduler::update_rate(unsigned ups)
+{
+    m_update_rate = ups;
+    m_update_ticks = ups ? m_frequency / ups : 0;
+    m_accumulator = 0;
+}
+
+void FrameScheduler::vsync(bool on)
+{
+    m_vsync = on;
+}
+
+void FrameScheduler::restart()
+{
+    m_started = false;
+}
+
+void FrameScheduler::begin_frame()
+{
+    const auto now = SDL_GetPerformanceCounter();
+    if (!m_started)
+    {
+        //  run a single update on the first frame
+        m_started = true;
+        m_last_time = now;
+        m_next_frame = now;
+        m_accumulator = m_update_ticks;
+    }
+    
+    m_accumulator += now - m_last_time;
+    m_last_time = now;
+    m_updates = 0;
+    
+    if (m_frame_ticks)
+    {
+        //  if the previous frame ran long, start counting from now instead of trying to make up for lost frames
+        m_next_frame += m_frame_ticks;
+        if (m_next_frame <= now)
+            m_next_frame = now + m_frame_ticks;
+    }
+}
+
+bool FrameScheduler::should_update()
+{
+    if (m_update_ticks == 0)
+        return m_updates++ == 0;    //  variable timestep: one update per frame
+    
+    if (m_accumulator < m_update_ticks)
+        return false;
+    
+    if (m_updates == MAX_UPDATES_PER_FRAME)
+    {
+        //  we're too far behind to catch up, drop the backlog instead of compounding it
+        m_accumulator %= m_update_ticks;
+        return false;
+    }
+    
+    m_accumulator -= m_update_ticks;
+    m_updates++;
+    return true;
+}
+
+void FrameScheduler::end_frame()
+{
+    if (m_frame_ticks == 0 || m_vsync)
+        return;
+    
+    if (auto delay = time_to_next_frame())
+        SDL_Delay(delay);
+}
+
+/// accessors:
+double FrameScheduler::alpha() const
+{
+    return m_update_ticks ? double(m_accumulator % m_update_ticks) / m_update_ticks : 0.0;
+}
+
+Uint32 FrameScheduler::time_to_next_frame() const
+{
+    if (m_frame_ticks == 0)
+        return 0;
+    
+    const auto now = SDL_GetPerformanceCounter();
+    return now < m_next_frame ? Uint32((m_next_frame - now) * 1000 / m_frequency) : 0;
+}
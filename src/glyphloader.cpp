@@ -0,0 +1,69 @@
+/*
+ *      Copyright (C) 2020 Johnathan Law
+ *
+ *      This file is part of SWL.
+ *
+ *      SWL is free software: you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation, either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      SWL is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with SWL.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "glyphloader.hpp"
+
+
+/// destructor:
+GlyphLoader::~GlyphLoader()
+{
+    for (auto& job : m_jobs)
+    {
+        job->worker.join();
+        FC_FreeGlyphSet(job->glyphs);
+    }
+}
+
+/// modifiers:
+bool GlyphLoader::load(SharedFont const& font, std::string const& filename, Uint32 point_size, int style,
+                       std::string const& charset)
+{
+    if (!font || charset.empty())
+        return false;
+    
+    //  opened here rather than by the worker: SDL_ttf doesn't guard opening and closing fonts
+    TTFont ttf(TTF_OpenFont(filename.data(), point_size), TTF_CloseFont);
+    if (!ttf)
+        return false;
+    TTF_SetFontStyle(ttf.get(), style);
+    
+    std::unique_ptr<Job> job{new Job{font, std::move(ttf), charset, nullptr, std::thread()}};
+    auto raw = job.get();
+    job->worker = std::thread([raw] { raw->glyphs = FC_RasterizeGlyphs(raw->ttf.get(), raw->charset.data()); });
+    m_jobs.push_back(std::move(job));
+    return true;
+}
+
+void GlyphLoader::upload()
+{
+    for (auto& job : m_jobs)
+    {
+        job->worker.join();
+        if (auto font = job->font.lock())
+        {
+            FC_AddGlyphSet(font.get(), job->glyphs);
+            
+            //  so that the glyphs are reloaded along with the font if the renderer is reset
+            FC_SetLoadingString(font.get(), job->charset.data());
+        }
+        FC_FreeGlyphSet(job->glyphs);
+    }
+    m_jobs.clear();
+}
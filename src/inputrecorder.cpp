@@ -0,0 +1,356 @@
+/*
+ *      Copyright (C) 2020 Johnathan Law
+ *
+ *      This file is part of SWL.
+ *
+ *      SWL is free software: you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation, either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      SWL is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with SWL.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "inputrecorder.hpp"
+
+#include "utility.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+
+static const char MAGIC[4] = {'S', 'W', 'L', 'R'};
+static constexpr Uint8 FORMAT_VERSION = 2;
+
+/**
+ * @brief   Record kinds. Every record starts with its kind (1 byte) and time (4 bytes),
+ *          followed by a fixed payload. Multi-byte values are little-endian.
+ */
+enum RecordKind : Uint8
+{
+    RECORD_FRAME,           //  updates, repeat
+    RECORD_QUIT,            //
+    RECORD_MOUSE_MOTION,    //  state, x, y, xrel, yrel
+    RECORD_MOUSE_DOWN,      //  button, clicks, x, y
+    RECORD_MOUSE_UP,        //  button, clicks, x, y
+    RECORD_MOUSE_WHEEL,     //  x, y, direction
+    RECORD_KEY_DOWN,        //  scancode, sym, mod, repeat
+    RECORD_KEY_UP,          //  scancode, sym, mod, repeat
+    RECORD_WINDOW,          //  event, data1, data2
+};
+
+
+/// helper functions:
+static void put8(std::ofstream& file, Uint8 value)
+{
+    file.put(static_cast<char>(value));
+}
+
+static void put16(std::ofstream& file, Uint16 value)
+{
+    put8(file, value & 0xFF);
+    put8(file, value >> 8);
+}
+
+static void put32(std::ofstream& file, Uint32 value)
+{
+    put16(file, value & 0xFFFF);
+    put16(file, value >> 16);
+}
+
+/**
+ * @brief   Reads little-endian values from a buffer. Reading past the end sets `failed`.
+ */
+struct RecordReader
+{
+    std::vector<Uint8> const& data;
+    std::size_t pos;
+    bool failed;
+    
+    bool done() const { return failed || pos >= data.size(); }
+    
+    Uint8 get8()
+    {
+        if (pos >= data.size())
+        {
+            failed = true;
+            return 0;
+        }
+        return data[pos++];
+    }
+    
+    Uint16 get16()
+    {
+        const Uint16 lo = get8();
+        return lo | Uint16(get8() << 8);
+    }
+    
+    Uint32 get32()
+    {
+        const Uint32 lo = get16();
+        return lo | (Uint32(get16()) << 16);
+    }
+};
+
+
+/// constructors:
+InputRecorder::InputRecorder() noexcept
+    : m_start{0}
+    , m_frame_events{0}
+    , m_idle_updates{0}
+    , m_idle_frames{0}
+    , m_idle_time{0}
+{
+}
+
+/// destructor:
+InputRecorder::~InputRecorder()
+{
+    stop();
+}
+
+/// modifiers:
+bool InputRecorder::start(std::string const& filename)
+{
+    stop();
+    m_file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!m_file)
+        return false;
+    
+    m_file.write(MAGIC, sizeof MAGIC);
+    put8(m_file, FORMAT_VERSION);
+    
+    m_start = SDL_GetTicks();
+    m_frame_events = 0;
+    m_idle_updates = 0;
+    m_idle_frames = 0;
+    return true;
+}
+
+void InputRecorder::stop()
+{
+    if (!is_recording())
+        return;
+    
+    if (m_frame_events > 0)
+        write_frame(elapsed(), 0);
+    else
+        write_idle_frames();
+    m_file.close();
+}
+
+void InputRecorder::record(SDL_Event const& event)
+{
+    if (!is_recording())
+        return;
+    
+    RecordKind kind;
+    switch (event.type)
+    {
+    case SDL_QUIT:              kind = RECORD_QUIT; break;
+    case SDL_MOUSEMOTION:       kind = RECORD_MOUSE_MOTION; break;
+    case SDL_MOUSEBUTTONDOWN:   kind = RECORD_MOUSE_DOWN; break;
+    case SDL_MOUSEBUTTONUP:     kind = RECORD_MOUSE_UP; break;
+    case SDL_MOUSEWHEEL:        kind = RECORD_MOUSE_WHEEL; break;
+    case SDL_KEYDOWN:           kind = RECORD_KEY_DOWN; break;
+    case SDL_KEYUP:             kind = RECORD_KEY_UP; break;
+    case SDL_WINDOWEVENT:       kind = RECORD_WINDOW; break;
+    default:                    return;
+    }
+    
+    //  the event-less frames before this one are written first
+    if (m_frame_events == 0)
+        write_idle_frames();
+    
+    put8(m_file, kind);
+    put32(m_file, elapsed());
+    
+    switch (kind)
+    {
+    case RECORD_MOUSE_MOTION:
+        put32(m_file, event.motion.state);
+        put32(m_file, event.motion.x);
+        put32(m_file, event.motion.y);
+        put32(m_file, event.motion.xrel);
+        put32(m_file, event.motion.yrel);
+        break;
+    case RECORD_MOUSE_DOWN:
+    case RECORD_MOUSE_UP:
+        put8(m_file, event.button.button);
+        put8(m_file, event.button.clicks);
+        put32(m_file, event.button.x);
+        put32(m_file, event.button.y);
+        break;
+    case RECORD_MOUSE_WHEEL:
+        put32(m_file, event.wheel.x);
+        put32(m_file, event.wheel.y);
+        put32(m_file, event.wheel.direction);
+        break;
+    case RECORD_KEY_DOWN:
+    case RECORD_KEY_UP:
+        put32(m_file, event.key.keysym.scancode);
+        put32(m_file, event.key.keysym.sym);
+        put16(m_file, event.key.keysym.mod);
+        put8(m_file, event.key.repeat);
+        break;
+    case RECORD_WINDOW:
+        put8(m_file, event.window.event);
+        put32(m_file, event.window.data1);
+        put32(m_file, event.window.data2);
+        break;
+    default:
+        break;
+    }
+    
+    ++m_frame_events;
+}
+
+void InputRecorder::end_frame(unsigned updates)
+{
+    if (!is_recording())
+        return;
+    
+    if (m_frame_events > 0)
+    {
+        write_frame(elapsed(), updates);
+    }
+    else
+    {
+        //  only frames which ran loop() equally often can share a marker
+        if (updates != m_idle_updates)
+            write_idle_frames();
+        m_idle_updates = updates;
+        ++m_idle_frames;
+        m_idle_time = elapsed();
+    }
+}
+
+/// accessors:
+std::vector<InputRecorder::Frame> InputRecorder::load(std::string const& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    Util::assert_true(file.is_open(), "[ERROR] Failed to open recording: " + filename);
+    
+    const std::vector<Uint8> data{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    Util::assert_true(data.size() > sizeof MAGIC && std::equal(MAGIC, MAGIC + sizeof MAGIC, data.begin())
+                      && data[sizeof MAGIC] == FORMAT_VERSION,
+                      "[ERROR] Not a recording (or an unsupported version): " + filename);
+    
+    std::vector<Frame> frames;
+    Frame frame{0, 0, 1, {}};
+    RecordReader reader{data, sizeof MAGIC + 1, false};
+    while (!reader.done())
+    {
+        const auto kind = reader.get8();
+        const auto time = reader.get32();
+        
+        SDL_Event event;
+        SDL_zero(event);
+        event.common.timestamp = time;
+        switch (kind)
+        {
+        case RECORD_FRAME:
+            frame.time = time;
+            frame.updates = reader.get32();
+            frame.repeat = std::max<Uint32>(reader.get32(), 1);
+            frames.push_back(std::move(frame));
+            frame = Frame{time, 0, 1, {}};
+            continue;
+        case RECORD_QUIT:
+            event.type = SDL_QUIT;
+            break;
+        case RECORD_MOUSE_MOTION:
+            event.type = SDL_MOUSEMOTION;
+            event.motion.state = reader.get32();
+            event.motion.x = reader.get32();
+            event.motion.y = reader.get32();
+            event.motion.xrel = reader.get32();
+            event.motion.yrel = reader.get32();
+            break;
+        case RECORD_MOUSE_DOWN:
+        case RECORD_MOUSE_UP:
+            event.type = (kind == RECORD_MOUSE_DOWN ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP);
+            event.button.state = (kind == RECORD_MOUSE_DOWN ? SDL_PRESSED : SDL_RELEASED);
+            event.button.button = reader.get8();
+            event.button.clicks = reader.get8();
+            event.button.x = reader.get32();
+            event.button.y = reader.get32();
+            break;
+        case RECORD_MOUSE_WHEEL:
+            event.type = SDL_MOUSEWHEEL;
+            event.wheel.x = reader.get32();
+            event.wheel.y = reader.get32();
+            event.wheel.direction = reader.get32();
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+            event.wheel.preciseX = event.wheel.x;
+            event.wheel.preciseY = event.wheel.y;
+#endif
+            break;
+        case RECORD_KEY_DOWN:
+        case RECORD_KEY_UP:
+            event.type = (kind == RECORD_KEY_DOWN ? SDL_KEYDOWN : SDL_KEYUP);
+            event.key.state = (kind == RECORD_KEY_DOWN ? SDL_PRESSED : SDL_RELEASED);
+            event.key.keysym.scancode = static_cast<SDL_Scancode>(reader.get32());
+            event.key.keysym.sym = static_cast<SDL_Keycode>(reader.get32());
+            event.key.keysym.mod = reader.get16();
+            event.key.repeat = reader.get8();
+            break;
+        case RECORD_WINDOW:
+            event.type = SDL_WINDOWEVENT;
+            event.window.event = reader.get8();
+            event.window.data1 = reader.get32();
+            event.window.data2 = reader.get32();
+            break;
+        default:
+            Util::assert_true(false, "[ERROR] Corrupt recording: " + filename);
+        }
+        
+        if (!reader.failed)
+            frame.events.push_back(event);
+    }
+    
+    //  a recording cut short (e.g. by a crash) may end without a frame marker
+    if (!frame.events.empty())
+        frames.push_back(std::move(frame));
+    
+    return frames;
+}
+
+/// helper functions:
+void InputRecorder::write_frame(Uint32 time, unsigned updates, unsigned repeat)
+{
+    put8(m_file, RECORD_FRAME);
+    put32(m_file, time);
+    put32(m_file, updates);
+    put32(m_file, repeat);
+    m_frame_events = 0;
+}
+
+void InputRecorder::write_idle_frames()
+{
+    if (m_idle_frames == 0)
+        return;
+    
+    write_frame(m_idle_time, m_idle_updates, m_idle_frames);
+    m_idle_frames = 0;
+}
+
+Uint32 InputRecorder::elapsed() const
+{
+    return SDL_GetTicks() - m_start;
+}
+
+
+std::ostream& operator<< (std::ostream& os, ReplayStats const& stats)
+{
+    return os << stats.frames << " frames (" << stats.redraws << " redrawn), " << stats.events << " events in "
+              << stats.total_ms << " ms; frame time: median " << stats.frame_median_ms << " ms, p90 "
+              << stats.frame_p90_ms << " ms, p99 " << stats.frame_p99_ms << " ms, max " << stats.frame_max_ms << " ms";
+}
@@ -89,22 +89,27 @@ MenuModel::MenuModel() noexcept
 /// modifiers:
 MenuNode* MenuModel::add(std::string const& text)
 {
-    return m_current_node->add(text);
+    auto node = m_current_node->add(text);
+    changed();
+    return node;
 }
 
 void MenuModel::clear()
 {
     m_current_node->clear();
+    changed();
 }
 
 void MenuModel::back_navigation(bool on)
 {
     m_back_navigation = on;
+    changed();
 }
 
 void MenuModel::go_to_root()
 {
     m_current_node = m_root_node.get();
+    changed();
 }
 
 bool MenuModel::go_to_parent()
@@ -113,6 +118,7 @@ bool MenuModel::go_to_parent()
         return false;
     
     m_current_node = m_current_node->parent();
+    changed();
     return true;
 }
 
@@ -126,6 +132,7 @@ bool MenuModel::go_to_index(std::size_t index)
         return false;
     
     m_current_node = node;
+    changed();
     return true;
 }
 
@@ -139,6 +146,7 @@ bool MenuModel::go_to_option(std::string const& text)
         return false;
     
     m_current_node = node;
+    changed();
     return true;
 }
 
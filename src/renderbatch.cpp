@@ -0,0 +1,180 @@
+/*
+ *      Copyright (C) 2020 Johnathan Law
+ *
+ *      This file is part of SWL.
+ *
+ *      SWL is free software: you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation, either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      SWL is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with SWL.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "renderbatch.hpp"
+
+
+RenderBatch* RenderBatch::s_active = nullptr;
+
+
+static bool same_color(SDL_Color const& a, SDL_Color const& b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+
+/// constructors:
+RenderBatch::RenderBatch(Renderer const& renderer)
+    : m_renderer{renderer.get()}
+    , m_state(RenderState::of(renderer.get()))
+    , m_previous{s_active}
+    , m_kind{NONE}
+    , m_color{0, 0, 0, 0}
+    , m_texture{nullptr}
+    , m_texture_w{0}
+    , m_texture_h{0}
+{
+    //  the outer batch's primitives come first
+    if (m_previous)
+        m_previous->flush();
+    s_active = this;
+}
+
+/// destructor:
+RenderBatch::~RenderBatch()
+{
+    flush();
+    s_active = m_previous;
+}
+
+/// modifiers:
+void RenderBatch::fill_rect(SDL_Rect const& rect, SDL_Color const& color)
+{
+    prepare(FILL_RECTS, color, nullptr);
+    m_rects.push_back(rect);
+}
+
+void RenderBatch::outline_rect(SDL_Rect const& rect, SDL_Color const& color)
+{
+    prepare(OUTLINE_RECTS, color, nullptr);
+    m_rects.push_back(rect);
+}
+
+void RenderBatch::copy(SDL_Texture* texture, SDL_Rect const* src, SDL_Rect const& dst)
+{
+    if (!texture)
+        return;
+    
+    SDL_Color color;
+    SDL_GetTextureColorMod(texture, &color.r, &color.g, &color.b);
+    SDL_GetTextureAlphaMod(texture, &color.a);
+    copy(texture, src, dst, color);
+}
+
+void RenderBatch::copy(SDL_Texture* texture, SDL_Rect const* src, SDL_Rect const& dst, SDL_Color const& color)
+{
+    if (!texture)
+        return;
+    
+    prepare(QUADS, color, texture);
+    m_quads.push_back(Quad{src ? *src : SDL_Rect{0, 0, m_texture_w, m_texture_h}, dst, color});
+}
+
+void RenderBatch::flush()
+{
+    switch (m_kind)
+    {
+    case FILL_RECTS:
+        m_state.draw_color(m_color);
+        SDL_RenderFillRects(m_renderer, m_rects.data(), int(m_rects.size()));
+        break;
+    case OUTLINE_RECTS:
+        m_state.draw_color(m_color);
+        SDL_RenderDrawRects(m_renderer, m_rects.data(), int(m_rects.size()));
+        break;
+    case QUADS:
+        flush_quads();
+        break;
+    case NONE:
+        break;
+    }
+    
+    m_rects.clear();
+    m_quads.clear();
+    m_kind = NONE;
+}
+
+/// helper functions:
+void RenderBatch::prepare(Kind kind, SDL_Color const& color, SDL_Texture* texture)
+{
+    //  quads carry their own colour, so only rects are split by colour
+    const bool same = m_kind == kind && (kind == QUADS ? m_texture == texture : same_color(m_color, color));
+    if (same)
+        return;
+    
+    flush();
+    m_kind = kind;
+    m_color = color;
+    m_texture = texture;
+    if (texture)
+        SDL_QueryTexture(texture, nullptr, nullptr, &m_texture_w, &m_texture_h);
+}
+
+void RenderBatch::flush_quads()
+{
+    //  the colour of each quad replaces the texture's own colour/alpha mod, restored afterwards
+    SDL_Color mod;
+    SDL_GetTextureColorMod(m_texture, &mod.r, &mod.g, &mod.b);
+    SDL_GetTextureAlphaMod(m_texture, &mod.a);
+    
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    m_state.texture_color_mod(m_texture, 255, 255, 255);
+    m_state.texture_alpha_mod(m_texture, 255);
+    
+    const float sx = m_texture_w ? 1.0f / m_texture_w : 0;
+    const float sy = m_texture_h ? 1.0f / m_texture_h : 0;
+    m_vertices.clear();
+    m_indices.clear();
+    for (auto const& quad : m_quads)
+    {
+        const int first = int(m_vertices.size());
+        const float x0 = float(quad.dst.x), y0 = float(quad.dst.y);
+        const float x1 = x0 + quad.dst.w, y1 = y0 + quad.dst.h;
+        const float u0 = quad.src.x * sx, v0 = quad.src.y * sy;
+        const float u1 = (quad.src.x + quad.src.w) * sx, v1 = (quad.src.y + quad.src.h) * sy;
+        
+        m_vertices.push_back(SDL_Vertex{{x0, y0}, quad.color, {u0, v0}});
+        m_vertices.push_back(SDL_Vertex{{x1, y0}, quad.color, {u1, v0}});
+        m_vertices.push_back(SDL_Vertex{{x1, y1}, quad.color, {u1, v1}});
+        m_vertices.push_back(SDL_Vertex{{x0, y1}, quad.color, {u0, v1}});
+        
+        const int indices[] = {first, first + 1, first + 2, first, first + 2, first + 3};
+        m_indices.insert(m_indices.end(), indices, indices + 6);
+    }
+    SDL_RenderGeometry(m_renderer, m_texture, m_vertices.data(), int(m_vertices.size()),
+                       m_indices.data(), int(m_indices.size()));
+#else
+    //  no geometry API: one copy per quad, changing the mod only when the colour changes
+    SDL_Color current = mod;
+    for (auto const& quad : m_quads)
+    {
+        if (!same_color(quad.color, current))
+        {
+            current = quad.color;
+            m_state.texture_color_mod(m_texture, current.r, current.g, current.b);
+            m_state.texture_alpha_mod(m_texture, current.a);
+        }
+        SDL_RenderCopy(m_renderer, m_texture, &quad.src, &quad.dst);
+    }
+#endif
+    
+    m_state.texture_color_mod(m_texture, mod.r, mod.g, mod.b);
+    m_state.texture_alpha_mod(m_texture, mod.a);
+}
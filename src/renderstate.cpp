@@ -0,0 +1,271 @@
+/*
+ *      Copyright (C) 2020 Johnathan Law
+ *
+ *      This file is part of SWL.
+ *
+ *      SWL is free software: you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation, either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      SWL is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with SWL.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "renderstate.hpp"
+
+#include <cassert>
+#include <memory>
+
+
+using StateMap = std::unordered_map<SDL_Renderer*, std::unique_ptr<RenderState>>;
+
+static StateMap& states()
+{
+    static StateMap map;
+    return map;
+}
+
+//  most applications have a single renderer, so remember the last lookup
+static SDL_Renderer* last_renderer = nullptr;
+static RenderState* last_state = nullptr;
+
+
+static bool same_color(SDL_Color const& a, SDL_Color const& b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+
+/// constructors:
+RenderState::RenderState(SDL_Renderer* renderer) noexcept
+    : m_renderer{renderer}
+    , m_draw_color{0, 0, 0, 0}
+    , m_blend_mode{SDL_BLENDMODE_NONE}
+    , m_target{nullptr}
+    , m_clip{0, 0, 0, 0}
+    , m_viewport{0, 0, 0, 0}
+    , m_draw_color_known{false}
+    , m_blend_mode_known{false}
+    , m_target_known{false}
+    , m_clip_known{false}
+    , m_viewport_known{false}
+    , m_issued{0}
+    , m_saved{0}
+{
+}
+
+/// modifiers:
+void RenderState::draw_color(SDL_Color const& color)
+{
+    if (!needed(m_draw_color_known && same_color(m_draw_color, color)))
+        return;
+    
+    SDL_SetRenderDrawColor(m_renderer, color.r, color.g, color.b, color.a);
+    m_draw_color = color;
+    m_draw_color_known = true;
+}
+
+void RenderState::blend_mode(SDL_BlendMode mode)
+{
+    if (!needed(m_blend_mode_known && m_blend_mode == mode))
+        return;
+    
+    SDL_SetRenderDrawBlendMode(m_renderer, mode);
+    m_blend_mode = mode;
+    m_blend_mode_known = true;
+}
+
+void RenderState::target(SDL_Texture* texture)
+{
+    if (!needed(m_target_known && m_target == texture))
+        return;
+    
+    SDL_SetRenderTarget(m_renderer, texture);
+    m_target = texture;
+    m_target_known = true;
+    m_clip_known = false;
+    m_viewport_known = false;
+}
+
+void RenderState::clip(SDL_Rect const* rect)
+{
+    const SDL_Rect wanted = rect ? *rect : SDL_Rect{0, 0, 0, 0};
+    if (!needed(m_clip_known && SDL_RectEquals(&m_clip, &wanted)))
+        return;
+    
+    SDL_RenderSetClipRect(m_renderer, rect);
+    m_clip = wanted;
+    m_clip_known = true;
+}
+
+void RenderState::viewport(SDL_Rect const* rect)
+{
+    if (!rect)
+    {
+        //  the size of the target isn't tracked, so let SDL work it out
+        needed(false);
+        SDL_RenderSetViewport(m_renderer, nullptr);
+        m_viewport_known = false;
+        return;
+    }
+    
+    if (!needed(m_viewport_known && SDL_RectEquals(&m_viewport, rect)))
+        return;
+    
+    SDL_RenderSetViewport(m_renderer, rect);
+    m_viewport = *rect;
+    m_viewport_known = true;
+}
+
+bool RenderState::push_context(SDL_Rect const& area)
+{
+    const Context current{viewport(), clip()};
+    m_contexts.push_back(current);
+    
+    //  the part of the current context that can be drawn to, relative to the current viewport
+    SDL_Rect visible = {0, 0, current.viewport.w, current.viewport.h};
+    if (!SDL_RectEmpty(&current.clip) && !SDL_IntersectRect(&visible, &current.clip, &visible))
+        return false;
+    if (!SDL_IntersectRect(&visible, &area, &visible))
+        return false;
+    
+    const SDL_Rect inner = {current.viewport.x + area.x, current.viewport.y + area.y, area.w, area.h};
+    visible.x -= area.x;
+    visible.y -= area.y;
+    viewport(&inner);
+    clip(&visible);
+    return true;
+}
+
+void RenderState::pop_context()
+{
+    assert(!m_contexts.empty());
+    
+    const auto previous = m_contexts.back();
+    m_contexts.pop_back();
+    viewport(&previous.viewport);
+    clip(SDL_RectEmpty(&previous.clip) ? nullptr : &previous.clip);
+}
+
+void RenderState::texture_color_mod(SDL_Texture* texture, Uint8 r, Uint8 g, Uint8 b)
+{
+    auto& mods = m_textures[texture];
+    if (!needed(mods.color_known && mods.mod.r == r && mods.mod.g == g && mods.mod.b == b))
+        return;
+    
+    SDL_SetTextureColorMod(texture, r, g, b);
+    mods.mod.r = r;
+    mods.mod.g = g;
+    mods.mod.b = b;
+    mods.color_known = true;
+}
+
+void RenderState::texture_alpha_mod(SDL_Texture* texture, Uint8 a)
+{
+    auto& mods = m_textures[texture];
+    if (!needed(mods.alpha_known && mods.mod.a == a))
+        return;
+    
+    SDL_SetTextureAlphaMod(texture, a);
+    mods.mod.a = a;
+    mods.alpha_known = true;
+}
+
+void RenderState::invalidate()
+{
+    m_draw_color_known = false;
+    m_blend_mode_known = false;
+    m_target_known = false;
+    m_clip_known = false;
+    m_viewport_known = false;
+    m_textures.clear();
+}
+
+void RenderState::reset_counters()
+{
+    m_issued = 0;
+    m_saved = 0;
+}
+
+/// accessors:
+SDL_Texture* RenderState::target()
+{
+    if (!m_target_known)
+    {
+        m_target = SDL_GetRenderTarget(m_renderer);
+        m_target_known = true;
+    }
+    return m_target;
+}
+
+SDL_Rect RenderState::clip()
+{
+    if (!m_clip_known)
+    {
+        SDL_RenderGetClipRect(m_renderer, &m_clip);
+        m_clip_known = true;
+    }
+    return m_clip;
+}
+
+SDL_Rect RenderState::viewport()
+{
+    if (!m_viewport_known)
+    {
+        SDL_RenderGetViewport(m_renderer, &m_viewport);
+        m_viewport_known = true;
+    }
+    return m_viewport;
+}
+
+RenderState& RenderState::of(SDL_Renderer* renderer)
+{
+    if (last_state && last_renderer == renderer)
+        return *last_state;
+    
+    auto& state = states()[renderer];
+    if (!state)
+        state.reset(new RenderState{renderer});
+    
+    last_renderer = renderer;
+    last_state = state.get();
+    return *state;
+}
+
+void RenderState::forget(SDL_Renderer* renderer)
+{
+    if (last_renderer == renderer)
+        last_state = nullptr;
+    states().erase(renderer);
+}
+
+void RenderState::forget(SDL_Texture* texture)
+{
+    for (auto& entry : states())
+    {
+        entry.second->m_textures.erase(texture);
+        if (entry.second->m_target == texture)
+        {
+            entry.second->m_target_known = false;
+            entry.second->m_clip_known = false;
+            entry.second->m_viewport_known = false;
+        }
+    }
+}
+
+/// helper functions:
+bool RenderState::needed(bool unchanged)
+{
+    if (unchanged)
+        ++m_saved;
+    else
+        ++m_issued;
+    return !unchanged;
+}
@@ -0,0 +1,108 @@
+/*
+ *      Copyright (C) 2020 Johnathan Law
+ *
+ *      This file is part of SWL.
+ *
+ *      SWL is free software: you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation, either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      SWL is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with SWL.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "spatialgrid.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+
+/// constructors:
+SpatialGrid::SpatialGrid(int cell_size) noexcept
+    : m_cell_size{cell_size}
+{
+    assert(cell_size > 0);
+}
+
+/// modifiers:
+void SpatialGrid::insert(ItemID id, SDL_Rect const& rect)
+{
+    const auto cells = cells_of(rect);
+    for (int cy = cells.y0; cy <= cells.y1; ++cy)
+        for (int cx = cells.x0; cx <= cells.x1; ++cx)
+            insert_into(key(cx, cy), id);
+}
+
+void SpatialGrid::remove(ItemID id, SDL_Rect const& rect)
+{
+    const auto cells = cells_of(rect);
+    for (int cy = cells.y0; cy <= cells.y1; ++cy)
+        for (int cx = cells.x0; cx <= cells.x1; ++cx)
+            remove_from(key(cx, cy), id);
+}
+
+void SpatialGrid::move(ItemID id, SDL_Rect const& from, SDL_Rect const& to)
+{
+    const auto old_cells = cells_of(from);
+    const auto new_cells = cells_of(to);
+    
+    //  small moves usually stay within the same cells
+    for (int cy = old_cells.y0; cy <= old_cells.y1; ++cy)
+        for (int cx = old_cells.x0; cx <= old_cells.x1; ++cx)
+            if (!new_cells.contains(cx, cy))
+                remove_from(key(cx, cy), id);
+    
+    for (int cy = new_cells.y0; cy <= new_cells.y1; ++cy)
+        for (int cx = new_cells.x0; cx <= new_cells.x1; ++cx)
+            if (!old_cells.contains(cx, cy))
+                insert_into(key(cx, cy), id);
+}
+
+void SpatialGrid::clear()
+{
+    m_cells.clear();
+}
+
+/// accessors:
+void SpatialGrid::query(int x, int y, std::vector<ItemID>& out) const
+{
+    auto it = m_cells.find(key(cell_of(x), cell_of(y)));
+    if (it != m_cells.end())
+        out.insert(out.end(), it->second.begin(), it->second.end());
+}
+
+/// helper functions:
+SpatialGrid::CellRange SpatialGrid::cells_of(SDL_Rect const& rect) const
+{
+    return {cell_of(rect.x), cell_of(rect.y), cell_of(rect.x + rect.w), cell_of(rect.y + rect.h)};
+}
+
+void SpatialGrid::insert_into(CellKey cell, ItemID id)
+{
+    auto& ids = m_cells[cell];
+    auto it = std::lower_bound(ids.begin(), ids.end(), id);
+    if (it == ids.end() || *it != id)
+        ids.insert(it, id);
+}
+
+void SpatialGrid::remove_from(CellKey cell, ItemID id)
+{
+    auto it = m_cells.find(cell);
+    if (it == m_cells.end())
+        return;
+    
+    auto& ids = it->second;
+    auto pos = std::lower_bound(ids.begin(), ids.end(), id);
+    if (pos != ids.end() && *pos == id)
+        ids.erase(pos);
+    
+    if (ids.empty())
+        m_cells.erase(it);
+}
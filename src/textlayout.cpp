@@ -0,0 +1,171 @@
+/*
+ *      Copyright (C) 2020 Johnathan Law
+ *
+ *      This file is part of SWL.
+ *
+ *      SWL is free software: you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation, either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      SWL is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with SWL.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "textlayout.hpp"
+
+#include <algorithm>
+
+
+/// constructors:
+TextLayout::TextLayout() noexcept
+    : m_extents{0, 0, 0, 0}
+    , m_valid{false}
+    , m_font{nullptr}
+    , m_bounds{0, 0, 0, 0}
+    , m_alignment{ALIGN_TOP_LEFT}
+    , m_line_spacing{0}
+    , m_letter_spacing{0}
+{
+}
+
+/// modifiers:
+void TextLayout::update(SharedFont const& font, std::string const& text, SDL_Rect const& bounds, Alignment alignment)
+{
+    const auto f = font.get();
+    if (!f)
+    {
+        invalidate();
+        clear();
+        return;
+    }
+    
+    const int line_height = FC_GetLineHeight(f);
+    const int line_spacing = FC_GetLineSpacing(f);
+    const int letter_spacing = FC_GetSpacing(f);
+    if (m_valid && m_font == f && SDL_RectEquals(&m_bounds, &bounds) && m_alignment == alignment
+        && m_line_spacing == line_spacing && m_letter_spacing == letter_spacing)
+        return;
+    
+    //  position the glyphs relative to the origin, as FC_DrawText() would, and measure as FC_MeasureText() does
+    clear();
+    int pen_x = 0;
+    int pen_y = 0;
+    int line_width = 0;
+    int width = 0;
+    int lines = 1;
+    const char* end = text.data() + text.size();
+    for (const char* c = text.data(); c < end; ++c)
+    {
+        if (*c == '\n')
+        {
+            width = std::max(width, line_width);
+            line_width = 0;
+            pen_x = 0;
+            pen_y += line_height + line_spacing;
+            ++lines;
+            continue;
+        }
+        
+        Uint32 codepoint;
+        if (static_cast<unsigned char>(*c) < 0x80)
+        {
+            codepoint = static_cast<unsigned char>(*c); //  ASCII: no decoding needed
+        }
+        else
+        {
+            if (c + U8_charsize(c) > end)
+                break;  //  truncated UTF-8 sequence
+            codepoint = FC_GetCodepointFromUTF8(&c, 1); //  skips the extra UTF-8 bytes
+        }
+        FC_GlyphData glyph;
+        if (!FC_GetGlyphData(f, &glyph, codepoint))
+        {
+            codepoint = ' ';
+            if (!FC_GetGlyphData(f, &glyph, codepoint))
+                continue;   //  skip bad characters
+        }
+        
+        line_width += glyph.rect.w;
+        if (codepoint != ' ')
+        {
+            m_levels.push_back(glyph.cache_level);
+            m_src.push_back(glyph.rect);
+            m_dst.push_back({pen_x, pen_y, glyph.rect.w, glyph.rect.h});
+        }
+        pen_x += glyph.rect.w + letter_spacing;
+    }
+    width = std::max(width, line_width);
+    const int height = line_height * lines + line_spacing * (lines - 1);
+    
+    //  align, as draw_text() does
+    auto x = bounds.x;
+    auto y = bounds.y;
+    if (alignment & ALIGN_LEFT)
+    {
+    }
+    else if (alignment & ALIGN_HCENTER)
+        x += (bounds.w - width) / 2;
+    else if (alignment & ALIGN_RIGHT)
+        x += bounds.w - width;
+    
+    if (alignment & ALIGN_TOP)
+    {
+    }
+    else if (alignment & ALIGN_VCENTER)
+        y += (bounds.h - height) / 2;
+    else if (alignment & ALIGN_BOTTOM)
+        y += bounds.h - height;
+    
+    for (auto& dst : m_dst)
+    {
+        dst.x += x;
+        dst.y += y;
+    }
+    
+    m_extents = {x, y, width, height};
+    m_valid = true;
+    m_font = f;
+    m_bounds = bounds;
+    m_alignment = alignment;
+    m_line_spacing = line_spacing;
+    m_letter_spacing = letter_spacing;
+}
+
+void TextLayout::invalidate()
+{
+    m_valid = false;
+}
+
+/// GUI functions:
+void TextLayout::render(Renderer const& renderer, SharedFont const& font) const
+{
+    if (!m_valid || !font || font.get() != m_font)
+        return;
+    
+    //  draw each run of glyphs from the same atlas in one go
+    const auto color = FC_GetDefaultColor(m_font);
+    const int count = static_cast<int>(m_levels.size());
+    for (int begin = 0, end; begin < count; begin = end)
+    {
+        end = begin + 1;
+        while (end < count && m_levels[end] == m_levels[begin])
+            ++end;
+        render_glyph_run(FC_GetGlyphCacheLevel(m_font, m_levels[begin]), renderer.get(),
+                         &m_src[begin], &m_dst[begin], end - begin, color);
+    }
+}
+
+/// helper functions:
+void TextLayout::clear()
+{
+    m_levels.clear();
+    m_src.clear();
+    m_dst.clear();
+}
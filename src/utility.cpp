@@ -27,10 +27,7 @@ void draw_text(Renderer const& renderer, int x, int y, TTFont const& font, SDL_C
         return;
     
     auto surface = make_surface(font, text, color);
-    auto texture = make_texture_from_surface(renderer, surface);
-    
-    SDL_Rect rect = {x, y, surface->w, surface->h};
-    SDL_RenderCopy(renderer.get(), texture.get(), nullptr, &rect);
+    draw_surface(renderer, surface, {x, y, surface->w, surface->h});
 }
 
 void draw_text(Renderer const& renderer, SDL_Rect const& bounds, SharedFont const& font, std::string const& text,
@@ -39,10 +36,11 @@ void draw_text(Renderer const& renderer, SDL_Rect const& bounds, SharedFont cons
     if (!font)
         return;
     
+    const auto extents = FC_MeasureText(font.get(), text.data(), text.size());
+    const int width = extents.w;
+    const int height = extents.h;
     auto x = bounds.x;
     auto y = bounds.y;
-    auto width = FC_GetWidth(font.get(), text.data());
-    auto height = FC_GetHeight(font.get(), text.data());
     
     if (align & ALIGN_LEFT)
     {
@@ -69,10 +67,34 @@ void draw_centered_text(Renderer const& renderer, SDL_Rect const& bounds, TTFont
         return;
     
     auto surface = make_surface(font, text, color);
-    auto texture = make_texture_from_surface(renderer, surface);
+    draw_surface(renderer, surface, {bounds.x + (bounds.w - surface->w)/2, bounds.y + (bounds.h - surface->h)/2, surface->w, surface->h});
+}
+
+void render_glyph_run(FC_Image* atlas, FC_Target* dest, const FC_Rect* src, const FC_Rect* dst, int count, SDL_Color color)
+{
+    if (auto list = DisplayList::recording())
+    {
+        for (int i = 0; i < count; ++i)
+            list->glyph(atlas, src[i], dst[i], color);
+    }
     
-    SDL_Rect rect = {bounds.x + (bounds.w - surface->w)/2, bounds.y + (bounds.h - surface->h)/2, surface->w, surface->h};
-    SDL_RenderCopy(renderer.get(), texture.get(), nullptr, &rect);
+    if (auto batch = RenderBatch::active())
+    {
+        for (int i = 0; i < count; ++i)
+            batch->copy(atlas, &src[i], dst[i], color);
+    }
+    else
+        FC_DefaultGeometryCallback(atlas, dest, src, dst, count, color);
+}
+
+FC_Rect render_glyph(FC_Image* src, FC_Rect* srcrect, FC_Target* dest, float x, float y, float xscale, float yscale)
+{
+    //  flipped glyphs are neither batched nor recorded: keep the draw order, and never replay the slice
+    if (auto batch = RenderBatch::active())
+        batch->flush();
+    if (auto list = DisplayList::recording())
+        list->mark_volatile();
+    return FC_DefaultRenderCallback(src, srcrect, dest, x, y, xscale, yscale);
 }
 
 namespace Util
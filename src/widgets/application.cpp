@@ -27,6 +27,10 @@
 #include "utility.hpp"
 
 #include "sdl_inc.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
 #include <string>
 
 
@@ -34,17 +38,30 @@ static const std::string DEFAULT_FONT_FILE = "demos/fonts/luximr.ttf";
 static const Uint32 DEFAULT_FONT_SIZE = 16;
 static const auto DEFAULT_FONT_COLOR = Themes::SECONDARY;
 
-static constexpr unsigned FPS = 50;
+static constexpr unsigned DEFAULT_FRAME_RATE = 60;
+static constexpr unsigned DEFAULT_UPDATE_RATE = 60;
 static constexpr unsigned MUSIC_FADE_TIME_MS = 500;
+static constexpr int IDLE_TIMEOUT_MS = 1000;   //  upper bound on blocking, in case redraw() is called without wake()
+static constexpr int EVENT_BATCH_SIZE = 64;    //  events drained from the queue at a time when coalescing
 
 /// constructor:
-Application::Application(SDL_Rect const& dimensions, std::string const& window_title, Uint32 window_flags, Uint32 renderer_flags)
-    : BaseApplication(dimensions.w, dimensions.h)
+Application::Application(SDL_Rect const& dimensions, std::string const& window_title, Uint32 window_flags, Uint32 renderer_flags, bool headless)
+    : BaseApplication(dimensions.w, dimensions.h, headless)
     , running{true}
     , music_enabled{true}
     , window_title{window_title}
     , window_flags{window_flags}
     , renderer_flags{renderer_flags}
+    , active_music_changed{false}
+    , idle_enabled{false}
+    , dirty_rects_enabled{false}
+    , coalescing_enabled{false}
+    , window_visible{headless || !(window_flags & (SDL_WINDOW_HIDDEN | SDL_WINDOW_MINIMIZED))}
+    , frame_pending{true}
+    , awake_until{0}
+    , wake_event{SDL_RegisterEvents(1)}
+    , scheduler{DEFAULT_FRAME_RATE, DEFAULT_UPDATE_RATE}
+    , focus_handler{*this}
 {
     //  this gets run when scenes are changed
     scene_handler.set_update_action([this]()
@@ -55,14 +72,29 @@ Application::Application(SDL_Rect const& dimensions, std::string const& window_t
     
     background(Themes::BACKGROUND);
     
-    Util::assert_true((window = make_window(window_title, x(), y(), width(), height(), window_flags)),
-                      "[ERROR] Failed to initialise Window: ${sdl_error}");
-    Util::assert_true((renderer = make_renderer(window, -1, renderer_flags)),
-                      "[ERROR] Failed to initialise Renderer: ${sdl_error})");
+    if (headless)
+    {
+        Util::assert_true((target = make_surface(width(), height(), SDL_PIXELFORMAT_RGBA8888)),
+                          "[ERROR] Failed to initialise offscreen Surface: ${sdl_error}");
+        Util::assert_true((renderer = make_software_renderer(target)),
+                          "[ERROR] Failed to initialise software Renderer: ${sdl_error}");
+    }
+    else
+    {
+        Util::assert_true((window = make_window(window_title, x(), y(), width(), height(), window_flags)),
+                          "[ERROR] Failed to initialise Window: ${sdl_error}");
+        Util::assert_true((renderer = make_renderer(window, -1, renderer_flags)),
+                          "[ERROR] Failed to initialise Renderer: ${sdl_error})");
+    }
     Util::assert_equals(SDL_RenderSetLogicalSize(renderer.get(), width(), height()), 0,
                         "[ERROR] Failed to set render logical size: ${sdl_error}");
     
-    TextInterface::default_font(add_font(DEFAULT_FONT_FILE, DEFAULT_FONT_SIZE, DEFAULT_FONT_COLOR));
+    //  let the display pace frames if the renderer was actually created with vsync
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer.get(), &info) == 0)
+        scheduler.vsync(info.flags & SDL_RENDERER_PRESENTVSYNC);
+    
+    TextInterface::default_font(add_font(DEFAULT_FONT_FILE, DEFAULT_FONT_SIZE, DEFAULT_FONT_COLOR, TTF_STYLE_NORMAL, Charset::ASCII));
 }
 
 /// destructor:
@@ -74,16 +106,211 @@ int Application::run()
     SDL_Event event;
     while (running)
     {
-        while (SDL_PollEvent(&event))
-            handle_event(event);
+        if (idle_enabled && is_idle())
+        {
+            //  nothing to do: sleep until something happens
+            if (SDL_WaitEventTimeout(&event, IDLE_TIMEOUT_MS))
+            {
+                recorder.record(event);
+                handle_event(event);
+            }
+            scheduler.restart();
+        }
+        
+        scheduler.begin_frame();
+        
+        poll_events();
         
         if (!running)
             break;
         
+        //  loop() consumes redraw requests, so decide whether to render beforehand
+        const bool dirty = !idle_enabled || !is_idle();
+        frame_pending = false;
+        
+        unsigned updates = 0;
+        for (; running && scheduler.should_update(); ++updates)
+            loop();
+        
+        if (dirty && window_visible)
+            render();
+        recorder.end_frame(updates);
+        scheduler.end_frame();
+    }
+    recorder.stop();
+    return 0;
+}
+
+int Application::run(int argc, const char* argv[])
+{
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--record") == 0)
+        {
+            record_input(argv[i + 1]);
+        }
+        else if (std::strcmp(argv[i], "--replay") == 0 || std::strcmp(argv[i], "--replay-fast") == 0)
+        {
+            const bool realtime = std::strcmp(argv[i], "--replay") == 0;
+            std::cout << replay(argv[i + 1], realtime) << std::endl;
+            return 0;
+        }
+    }
+    return run();
+}
+
+bool Application::step(unsigned updates)
+{
+    poll_events();
+    frame_pending = false;
+    
+    unsigned i = 0;
+    for (; running && i < updates; ++i)
         loop();
+    
+    if (running && window_visible)
         render();
+    recorder.end_frame(i);
+    return running;
+}
+
+void Application::record_input(std::string const& filename)
+{
+    Util::assert_true(recorder.start(filename), "[ERROR] Failed to open recording file: " + filename);
+}
+
+ReplayStats Application::replay(std::string const& filename, bool realtime)
+{
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    
+    const auto frames = InputRecorder::load(filename);
+    
+    ReplayStats stats;
+    std::vector<double> frame_times;
+    frame_times.reserve(frames.size());
+    
+    const auto start = Clock::now();
+    const Uint32 start_ticks = SDL_GetTicks();
+    Uint32 previous_time = 0;
+    for (auto const& recorded : frames)
+    {
+        //  a marker may stand for several event-less frames: each is replayed on its own
+        for (unsigned n = 0; running && n < recorded.repeat; ++n)
+        {
+            if (realtime)
+            {
+                //  repeated frames are spread evenly since the previous marker
+                const Uint32 due = previous_time + Uint32(Uint64(recorded.time - previous_time) * (n + 1) / recorded.repeat);
+                const Uint32 elapsed = SDL_GetTicks() - start_ticks;
+                if (elapsed < due)
+                    SDL_Delay(due - elapsed);
+            }
+            
+            const auto frame_start = Clock::now();
+            
+            //  real input is ignored, except for requests to close the window
+            SDL_Event event;
+            while (SDL_PollEvent(&event))
+            {
+                if (event.type == SDL_QUIT)
+                    quit();
+            }
+            
+            if (n == 0)
+            {
+                SDL_Event pending;
+                bool has_pending = false;
+                for (auto const& e : recorded.events)
+                    dispatch_event(e, pending, has_pending);
+                if (has_pending)
+                    handle_event(pending);
+                stats.events += recorded.events.size();
+            }
+            
+            if (!running)
+                break;
+            
+            //  mirror run(): loop() consumes redraw requests, so decide whether to render beforehand
+            const bool dirty = !idle_enabled || !is_idle();
+            frame_pending = false;
+            
+            for (unsigned i = 0; running && i < recorded.updates; ++i)
+                loop();
+            
+            if (running && dirty && window_visible && render())
+                ++stats.redraws;
+            
+            frame_times.push_back(Milliseconds(Clock::now() - frame_start).count());
+            ++stats.frames;
+        }
+        
+        if (!running)
+            break;
+        previous_time = recorded.time;
     }
-    return 0;
+    stats.total_ms = Milliseconds(Clock::now() - start).count();
+    
+    if (!frame_times.empty())
+    {
+        std::sort(frame_times.begin(), frame_times.end());
+        const auto percentile = [&frame_times](double p)
+        {
+            return frame_times[static_cast<std::size_t>(p * (frame_times.size() - 1) + 0.5)];
+        };
+        stats.frame_median_ms = percentile(0.5);
+        stats.frame_p90_ms = percentile(0.9);
+        stats.frame_p99_ms = percentile(0.99);
+        stats.frame_max_ms = frame_times.back();
+    }
+    return stats;
+}
+
+void Application::frame_rate(unsigned fps)
+{
+    scheduler.frame_rate(fps);
+}
+
+void Application::update_rate(unsigned ups)
+{
+    scheduler.update_rate(ups);
+}
+
+void Application::idle_mode(bool on)
+{
+    idle_enabled = on;
+}
+
+void Application::dirty_rect_rendering(bool on)
+{
+    dirty_rects_enabled = on;
+    if (on && !frame)
+        frame = make_texture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width(), height());
+    
+    redraw();   //  the backing texture starts out with garbage
+}
+
+void Application::input_coalescing(bool on)
+{
+    coalescing_enabled = on;
+}
+
+void Application::keep_awake(Uint32 ms)
+{
+    const auto until = SDL_GetTicks() + ms;
+    if (SDL_TICKS_PASSED(until, awake_until))
+        awake_until = until;
+}
+
+void Application::wake() const
+{
+    if (wake_event == (Uint32)-1)
+        return;
+    
+    SDL_Event event;
+    SDL_zero(event);
+    event.type = wake_event;
+    SDL_PushEvent(&event);
 }
 
 /// accessors:
@@ -92,14 +319,81 @@ Renderer const& Application::get_renderer() const
     return renderer;
 }
 
+FocusManager* Application::focus_manager()
+{
+    return &focus_handler;
+}
+
+bool Application::is_headless() const
+{
+    return bool(target);
+}
+
+std::vector<Uint32> Application::read_pixels() const
+{
+    return read_pixels({0, 0, width(), height()});
+}
+
+std::vector<Uint32> Application::read_pixels(SDL_Rect const& region) const
+{
+    std::vector<Uint32> pixels(std::max(region.w, 0) * std::max(region.h, 0));
+    if (pixels.empty())
+        return pixels;
+    
+    //  with dirty-rect rendering, the backing texture always holds the whole frame
+    const bool from_frame = dirty_rects_enabled && frame;
+    auto& state = RenderState::of(renderer.get());
+    if (from_frame)
+        state.target(frame.get());
+    
+    const int status = SDL_RenderReadPixels(renderer.get(), &region, SDL_PIXELFORMAT_RGBA8888,
+                                            pixels.data(), region.w * sizeof(Uint32));
+    
+    if (from_frame)
+        state.target(nullptr);
+    
+    Util::assert_equals(status, 0, "[ERROR] Failed to read pixels: ${sdl_error}");
+    return pixels;
+}
+
+unsigned Application::frame_rate() const
+{
+    return scheduler.frame_rate();
+}
+
+unsigned Application::update_rate() const
+{
+    return scheduler.update_rate();
+}
+
+bool Application::idle_mode() const
+{
+    return idle_enabled;
+}
+
+bool Application::dirty_rect_rendering() const
+{
+    return dirty_rects_enabled;
+}
+
+bool Application::input_coalescing() const
+{
+    return coalescing_enabled;
+}
+
 /// protected modifiers:
-FontRef Application::add_font(std::string const& filename, Uint32 point_size, SDL_Color const& color, int style)
+FontRef Application::add_font(std::string const& filename, Uint32 point_size, SDL_Color const& color, int style,
+                              std::string const& charset)
 {
     if (!renderer)
         return FontRef();
-        
-    auto font = make_shared_font(renderer, filename, point_size, color, style);
+    
+    //  with a charset, nothing is rasterized upfront: the loader does it in the background
+    //  (if it can't, glyphs are rasterized on first use as usual)
+    auto font = make_shared_font(renderer, filename, point_size, color, style, charset.empty() ? nullptr : "");
     Util::assert_true(font, "[ERROR] Failed to initialise font: " + filename);
+    if (!charset.empty())
+        glyph_loader.load(font, filename, point_size, style, charset);
     fonts.push_back(font);
     return FontRef(font);
 }
@@ -159,6 +453,101 @@ void Application::toggle_music()
 }
 
 /// GUI events:
+void Application::poll_events()
+{
+    SDL_Event event;
+    if (!coalescing_enabled)
+    {
+        while (SDL_PollEvent(&event))
+        {
+            recorder.record(event);
+            handle_event(event);
+        }
+        return;
+    }
+    
+    SDL_Event batch[EVENT_BATCH_SIZE];
+    SDL_Event pending;
+    bool has_pending = false;
+    
+    SDL_PumpEvents();
+    int count;
+    while ((count = SDL_PeepEvents(batch, EVENT_BATCH_SIZE, SDL_GETEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT)) > 0)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            recorder.record(batch[i]);
+            dispatch_event(batch[i], pending, has_pending);
+        }
+        
+        if (count < EVENT_BATCH_SIZE)
+            break;  //  drained
+    }
+    
+    if (has_pending)
+        handle_event(pending);
+}
+
+bool Application::coalesce(SDL_Event& pending, SDL_Event const& event)
+{
+    if (pending.type != event.type)
+        return false;
+    
+    switch (event.type)
+    {
+    case SDL_MOUSEMOTION:
+        if (pending.motion.windowID != event.motion.windowID || pending.motion.which != event.motion.which)
+            return false;
+        
+        pending.motion.timestamp = event.motion.timestamp;
+        pending.motion.state = event.motion.state;
+        pending.motion.x = event.motion.x;
+        pending.motion.y = event.motion.y;
+        pending.motion.xrel += event.motion.xrel;
+        pending.motion.yrel += event.motion.yrel;
+        return true;
+        
+    case SDL_MOUSEWHEEL:
+        if (pending.wheel.windowID != event.wheel.windowID || pending.wheel.which != event.wheel.which
+            || pending.wheel.direction != event.wheel.direction)
+            return false;
+        
+        pending.wheel.timestamp = event.wheel.timestamp;
+        pending.wheel.x += event.wheel.x;
+        pending.wheel.y += event.wheel.y;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+        pending.wheel.preciseX += event.wheel.preciseX;
+        pending.wheel.preciseY += event.wheel.preciseY;
+#endif
+        return true;
+        
+    default:
+        return false;
+    }
+}
+
+void Application::dispatch_event(SDL_Event const& event, SDL_Event& pending, bool& has_pending)
+{
+    if (!coalescing_enabled)
+    {
+        handle_event(event);
+        return;
+    }
+    
+    if (has_pending && coalesce(pending, event))
+        return;
+    
+    //  dispatch the merged run before anything else, so that e.g. clicks see the latest position
+    if (has_pending)
+        handle_event(pending);
+    
+    has_pending = (event.type == SDL_MOUSEMOTION || event.type == SDL_MOUSEWHEEL);
+    if (has_pending)
+        pending = event;
+    else
+        handle_event(event);
+}
+
 bool Application::handle_event(SDL_Event const& event)
 {
     switch (event.type)
@@ -171,8 +560,14 @@ bool Application::handle_event(SDL_Event const& event)
     case SDL_MOUSEBUTTONUP:
     case SDL_MOUSEBUTTONDOWN:
     case SDL_MOUSEMOTION:
-        handle_mouse_event(Util::make_mouse_event(event));
+    {
+        const auto mouse_event = Util::make_mouse_event(event);
+        handle_mouse_event(mouse_event);
+        update_hover(mouse_event);
+        if (event.type == SDL_MOUSEBUTTONDOWN)
+            focus_hovered();
         break;
+    }
         
     case SDL_MOUSEWHEEL:
         handle_wheel_event(Util::make_wheel_event(event));
@@ -180,27 +575,114 @@ bool Application::handle_event(SDL_Event const& event)
         
     case SDL_KEYUP:
     case SDL_KEYDOWN:
-        handle_key_event(Util::make_key_event(event));
+        focus_handler.handle_key_event(Util::make_key_event(event));
+        break;
+        
+    case SDL_WINDOWEVENT:
+        switch (event.window.event)
+        {
+        case SDL_WINDOWEVENT_HIDDEN:
+        case SDL_WINDOWEVENT_MINIMIZED:
+            window_visible = false;
+            break;
+        case SDL_WINDOWEVENT_SHOWN:
+        case SDL_WINDOWEVENT_RESTORED:
+        case SDL_WINDOWEVENT_MAXIMIZED:
+        case SDL_WINDOWEVENT_EXPOSED:
+            window_visible = true;
+            break;
+        case SDL_WINDOWEVENT_LEAVE:
+        {
+            //  the cursor left the window, so nothing is hovered anymore
+            SDL_Event motion;
+            SDL_zero(motion);
+            motion.type = SDL_MOUSEMOTION;
+            motion.motion.state = SDL_GetMouseState(&motion.motion.x, &motion.motion.y);
+            handle_mouse_leave(Util::make_mouse_event(motion));
+            break;
+        }
+        default:
+            break;
+        }
         break;
         
     default:
         break;
     }
+    
+    //  assume any event may have changed what is on screen (including wake events)
+    frame_pending = true;
     return true;
 }
 
-void Application::render() const
+void Application::focus_hovered()
 {
-    //  clear
-    reset_target(renderer);
-    set_render_color(renderer, m_background_color);
-    SDL_RenderClear(renderer.get());
+    WidgetItem* target = nullptr;
+    Canvas* canvas = this;
+    while (canvas)
+    {
+        auto hovered = canvas->hovered_child();
+        if (!hovered)
+            break;
+        
+        if (hovered->is_focusable() && hovered->is_enabled())
+            target = hovered;
+        canvas = dynamic_cast<Canvas*>(hovered);
+    }
+    
+    if (target)
+        focus_handler.focus(target);
+}
+
+bool Application::is_idle() const
+{
+    //  while the window is hidden, nothing gets rendered, so there is no point staying awake
+    return !frame_pending && !active_music_changed && !needs_update()
+        && (!window_visible || SDL_TICKS_PASSED(SDL_GetTicks(), awake_until));
+}
+
+void Application::update(Renderer const& renderer)
+{
+    update_children(renderer);
+}
+
+bool Application::render()
+{
+    //  fonts must have their preloaded glyphs before they're drawn with
+    glyph_loader.upload();
+    
+    const auto region = consume_damage();
+    
+    if (!dirty_rects_enabled || !frame)
+    {
+        //  clear
+        reset_target(renderer);
+        set_render_color(renderer, m_background_color);
+        SDL_RenderClear(renderer.get());
+        
+        //  draw
+        render_children(renderer);
+        
+        //  show
+        reset_target(renderer);
+        SDL_RenderPresent(renderer.get());
+        return true;
+    }
     
-    //  draw
+    if (SDL_RectEmpty(&region))
+        return false;   //  nothing changed: keep the last frame on screen
+    
+    //  repaint the damaged region onto the backing texture
+    auto& state = RenderState::of(renderer.get());
+    state.target(frame.get());
+    state.clip(&region);
+    draw_filled_rect(renderer, region, m_background_color);
     render_children(renderer);
+    state.clip(nullptr);
     
-    //  show
+    //  the back buffer is undefined after presenting, so always copy the full frame
     reset_target(renderer);
+    SDL_RenderCopy(renderer.get(), frame.get(), nullptr, nullptr);
     SDL_RenderPresent(renderer.get());
-    SDL_Delay(FPS); //  TODO: abstract the delay (framerate?)?
+    return true;
 }
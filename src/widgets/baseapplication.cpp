@@ -29,9 +29,16 @@
 
 
 /// constructor:
-BaseApplication::BaseApplication(int width, int height)
+BaseApplication::BaseApplication(int width, int height, bool headless)
     : Canvas(width, height)
 {
+    if (headless)
+    {
+        //  don't overwrite, so that e.g. the offscreen driver can be picked from the environment
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+        SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+    }
+    
     Util::assert_equals(SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO), 0, "[ERROR] SDL_Init - ${sdl_error}");
     
     int img_flags = IMG_INIT_PNG | IMG_INIT_JPG;
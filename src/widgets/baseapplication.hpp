@@ -30,12 +30,16 @@
 
 /**
  * @brief   Manages core SDL initialisation and destruction.
+ *
+ * @note    When `headless`, SDL is initialised with the dummy video and audio drivers (unless
+ *          SDL_VIDEODRIVER/SDL_AUDIODRIVER are set, e.g. to "offscreen"), so that no display
+ *          or sound device is needed.
  */
 class BaseApplication : public Canvas
 {
 public:
     /// constructors:
-    BaseApplication(int width, int height);
+    BaseApplication(int width, int height, bool headless = false);
     BaseApplication(BaseApplication const&) = delete;
     BaseApplication(BaseApplication&&) = delete;
     
@@ -22,6 +22,7 @@
 #include <iostream>
 #include <cassert>
 #include <functional>
+#include <limits>
 
 
 /*-- class TargetWrapper --*/
@@ -29,7 +30,8 @@
  * @brief   A wrapper class for applying a temporary target to a renderer.
  *
  * @note    The target is applied on object construction,
- *          and the preceding target is restored on object destruction.
+ *          and the preceding target is restored on object destruction,
+ *          along with its viewport and clip rect (see RenderState::push_context()).
  * @note    Usage:
  *              {
  *                  auto var = TargetWrapper{renderer, texture};
@@ -49,6 +51,8 @@ class TargetWrapper
 {
     Renderer const&  m_renderer;
     SDL_Texture* m_prev_target;
+    SDL_Rect m_prev_viewport;
+    SDL_Rect m_prev_clip;
     bool m_target_ok;  //  TODO: change to C++17 std::optional
     
 public:
@@ -71,14 +75,20 @@ public:
 /// constructors:
 TargetWrapper::TargetWrapper(Renderer const& renderer, Texture const& target)
     : m_renderer{renderer}
-    , m_prev_target{SDL_GetRenderTarget(renderer.get())}
+    , m_prev_target{RenderState::of(renderer.get()).target()}
+    , m_prev_viewport(RenderState::of(renderer.get()).viewport())
+    , m_prev_clip(RenderState::of(renderer.get()).clip())
     , m_target_ok{true}
 {
-    SDL_SetRenderTarget(renderer.get(), target.get());
+    if (auto batch = RenderBatch::active())
+        batch->flush(); //  pending primitives belong to the previous target
+    RenderState::of(renderer.get()).target(target.get());
 }
 TargetWrapper::TargetWrapper(TargetWrapper&& other)
     : m_renderer{other.m_renderer}
     , m_prev_target{other.m_prev_target}
+    , m_prev_viewport(other.m_prev_viewport)
+    , m_prev_clip(other.m_prev_clip)
     , m_target_ok{true}
 {
     other.m_target_ok = false;    //  set false to prevent "premature unwrapping"
@@ -88,7 +98,14 @@ TargetWrapper::TargetWrapper(TargetWrapper&& other)
 TargetWrapper::~TargetWrapper()
 {
     if (m_target_ok)
-        SDL_SetRenderTarget(m_renderer.get(), m_prev_target);
+    {
+        if (auto batch = RenderBatch::active())
+            batch->flush();
+        auto& state = RenderState::of(m_renderer.get());
+        state.target(m_prev_target);
+        state.viewport(&m_prev_viewport);
+        state.clip(SDL_RectEmpty(&m_prev_clip) ? nullptr : &m_prev_clip);
+    }
 }
 
 /// convenience functions:
@@ -98,47 +115,59 @@ TargetWrapper::operator Renderer const&() const
 }
 
 
-/*-- class Canvas --*/
-using namespace std::placeholders;
-
-#define findmove(from, to)  \
-    {\
-        auto it = from.find(id);\
-        if (it != from.end())\
-        {\
-            /* insert item into target container */\
-            to[it->first] = std::move(it->second);\
-            \
-            /* remove item from first container */\
-            from.erase(it);\
-            return;\
-        }\
-    }
+/*-- class ContextWrapper --*/
+/**
+ * @brief   A wrapper class for drawing relative to an area of the current render context,
+ *          clipped to that area (see RenderState::push_context()).
+ *
+ * @note    The context is entered on object construction, and left on object destruction.
+ *          Check the wrapper before drawing: it converts to false if the area isn't visible.
+ */
+class ContextWrapper
+{
+    Renderer const& m_renderer;
+    bool m_visible;
+    
+public:
+    /// constructors:
+    ContextWrapper(Renderer const& renderer, SDL_Rect const& area);
+    ContextWrapper(ContextWrapper const&) = delete;
+    
+    /// destructor:
+    ~ContextWrapper();
+    
+    /// assignment:
+    ContextWrapper& operator=(ContextWrapper const&) = delete;
+    
+    /// convenience functions:
+    explicit operator bool() const;
+};
 
-#define moveall(from, to)   \
-    for (auto it = from.begin(); it != from.end();)\
-    {\
-        to[it->first] = std::move(it->second);\
-        it = from.erase(it);\
-    }
+/// constructors:
+ContextWrapper::ContextWrapper(Renderer const& renderer, SDL_Rect const& area)
+    : m_renderer{renderer}
+{
+    if (auto batch = RenderBatch::active())
+        batch->flush(); //  pending primitives belong to the outer context
+    m_visible = RenderState::of(renderer.get()).push_context(area);
+}
 
-#define iterate_impl(container, begin, end)  \
-    for (auto it = container.begin, next = it; it != container.end; it = next)\
-    {\
-        ++next;\
-        f(it->second.get());\
-    }
+/// destructor:
+ContextWrapper::~ContextWrapper()
+{
+    if (auto batch = RenderBatch::active())
+        batch->flush();
+    RenderState::of(m_renderer.get()).pop_context();
+}
 
-#define iterate(container) iterate_impl(container, begin(), end())
-#define iterate_const(container) iterate_impl(container, cbegin(), cend())
+/// convenience functions:
+ContextWrapper::operator bool() const
+{
+    return m_visible;
+}
 
-#define findret(container) \
-    {\
-        auto it = container.find(id);\
-        if (it != container.end())\
-        return it->second.get();\
-    }
 
+/*-- class Canvas --*/
 /// modifiers:
 Canvas& Canvas::on_redraw(RedrawFunc func)
 {
@@ -156,51 +185,126 @@ Canvas& Canvas::blend(SDL_BlendMode mode)
 Canvas& Canvas::redraw()
 {
     m_redraw = true;
-    return *this;
+    return damage({0, 0, m_dimensions.w, m_dimensions.h});
 }
 
-ItemID Canvas::add_item(std::string const& name, WidgetItem* item)
+Canvas& Canvas::damage(SDL_Rect const& region)
 {
-    if (name.empty())
+    if (SDL_RectEmpty(&region))
+        return *this;
+    
+    SDL_Rect bounds = {0, 0, m_dimensions.w, m_dimensions.h};
+    SDL_Rect clipped;
+    if (!SDL_IntersectRect(&region, &bounds, &clipped))
+        return *this;   //  nothing visible was damaged
+    
+    if (SDL_RectEmpty(&m_damage))
+        m_damage = clipped;
+    else
+        SDL_UnionRect(&m_damage, &clipped, &m_damage);
+    
+    if (m_parent)
     {
-        return add_item(item);
+        //  children are drawn relative to the canvas, so translate to the parent's coordinates
+        m_parent->mark_subtree_dirty();
+        m_parent->damage({clipped.x + m_dimensions.x, clipped.y + m_dimensions.y, clipped.w, clipped.h});
     }
-    else
+    return *this;
+}
+
+Canvas& Canvas::spatial_index(int cell_size)
+{
+    if (cell_size <= 0)
     {
-        m_visible_items[++m_id_counter] = std::unique_ptr<WidgetItem>(item);
-        m_name_to_id[name] = m_id_counter;
-        item->id = m_id_counter;
-        return m_id_counter;
+        m_spatial_index.reset();
+        return *this;
     }
+    
+    m_spatial_index.reset(new SpatialGrid{cell_size});
+    for (std::size_t i = 0; i < m_children.size(); ++i)
+        m_spatial_index->insert(ItemID(i + 1), m_children[i]->m_dimensions);
+    return *this;
+}
+
+Canvas& Canvas::display_list(bool on)
+{
+    if (on && !m_display_list)
+        m_display_list.reset(new DisplayList);
+    else if (!on)
+        m_display_list.reset();
+    return *this;
+}
+
+Canvas& Canvas::batch_rendering(bool on)
+{
+    m_batching = on;
+    return *this;
+}
+
+Canvas& Canvas::viewport_culling(bool on)
+{
+    m_viewport_culling = on;
+    return *this;
+}
+
+Canvas& Canvas::occlusion_culling(bool on)
+{
+    m_occlusion_culling = on;
+    return *this;
+}
+
+Canvas& Canvas::focus_scope(bool on)
+{
+    m_focus_scope = on;
+    return *this;
+}
+
+ItemID Canvas::add_item(std::string const& name, WidgetItem* item)
+{
+    const auto id = add_item(item);
+    if (!name.empty())
+        m_name_to_id[name] = id;
+    return id;
 }
 
 ItemID Canvas::add_item(WidgetItem* item)
 {
-    m_visible_items[++m_id_counter] = std::unique_ptr<WidgetItem>(item);
-    item->id = m_id_counter;
-    return m_id_counter;
+    return adopt(item, false);
 }
 
 ItemID Canvas::add_canvas(std::string const& name, Canvas* item)
 {
-    if (name.empty())
-    {
-        return add_canvas(item);
-    }
-    else
-    {
-        m_visible_canvases[++m_id_counter] = std::unique_ptr<Canvas>(item);
-        m_name_to_id[name] = m_id_counter;
-        item->id = m_id_counter;
-        return m_id_counter;
-    }
+    const auto id = add_canvas(item);
+    if (!name.empty())
+        m_name_to_id[name] = id;
+    return id;
 }
 
 ItemID Canvas::add_canvas(Canvas* item)
 {
-    m_visible_canvases[++m_id_counter] = std::unique_ptr<Canvas>(item);
-    item->id = m_id_counter;
-    return m_id_counter;
+    const auto id = adopt(item, true);
+    if (item->needs_update())
+        mark_subtree_dirty();
+    return id;
+}
+
+ItemID Canvas::add_items(std::vector<WidgetItem*> const& items)
+{
+    if (items.empty())
+        return 0;
+    
+    reserve(m_children.size() + items.size());
+    const auto first = ItemID(m_children.size() + 1);
+    for (auto item : items)
+        adopt(item, false);
+    return first;
+}
+
+void Canvas::reserve(std::size_t n)
+{
+    m_children.reserve(n);
+    m_visible.reserve(n);
+    m_is_canvas.reserve(n);
 }
 
 //void Canvas::remove(WidgetItem* item)
@@ -243,55 +347,47 @@ ItemID Canvas::add_canvas(Canvas* item)
 
 void Canvas::foreach_child(std::function<void(WidgetItem*)> f, ChildFlags flags)
 {
-    //  iterate over containers based on flags
-    if (flags & VISIBLE)
-    {
-        if (flags & ITEMS) { iterate(m_visible_items) }
-        else if (flags & CANVASES) { iterate(m_visible_canvases) }
-        else
-        {
-            //  only VISIBLE was specified but neither ITEMS/CANVASES were... so apply `f` to all
-            iterate(m_visible_canvases)
-            iterate(m_visible_items)
-        }
-    }
-    
-    if (flags & INVISIBLE)
-    {
-        if (flags & ITEMS) { iterate(m_invisible_items) }
-        else if (flags & CANVASES) { iterate(m_invisible_canvases) }
-        else
-        {
-            iterate(m_invisible_canvases)
-            iterate(m_invisible_items)
-        }
-    }
+    for_each_child(f, flags);
 }
     
 void Canvas::show(ItemID id)
 {
-    //  move item with given id from invisible to visible
-    findmove(m_invisible_canvases, m_visible_canvases)
-    findmove(m_invisible_items, m_visible_items)
+    if (id == 0 || id > m_children.size() || m_visible[id - 1])
+        return;
+    
+    m_visible[id - 1] = true;
+    m_hit_valid = false;
+    damage(m_children[id - 1]->m_dimensions);
+    
+    //  hidden canvases aren't updated, so they may have changed in the meantime
+    if (m_is_canvas[id - 1])
+        mark_subtree_dirty();
 }
 
 void Canvas::hide(ItemID id)
 {
-    //  move item with given id from visible to invisible
-    findmove(m_visible_canvases, m_invisible_canvases)
-    findmove(m_visible_items, m_invisible_items)
+    if (id == 0 || id > m_children.size() || !m_visible[id - 1])
+        return;
+    
+    m_visible[id - 1] = false;
+    m_hit_valid = false;
+    damage(m_children[id - 1]->m_dimensions);
 }
 
 void Canvas::show_children()
 {
-    moveall(m_invisible_canvases, m_visible_canvases)
-    moveall(m_invisible_items, m_visible_items)
+    if (!m_canvas_ids.empty())
+        mark_subtree_dirty();
+    m_visible.assign(m_children.size(), true);
+    m_hit_valid = false;
+    redraw();
 }
 
 void Canvas::hide_children()
 {
-    moveall(m_visible_canvases, m_invisible_canvases)
-    moveall(m_visible_items, m_invisible_items)
+    m_visible.assign(m_children.size(), false);
+    m_hit_valid = false;
+    redraw();
 }
 
 /// accessors:
@@ -303,54 +399,81 @@ WidgetItem* Canvas::child(std::string const& name) const
 
 WidgetItem* Canvas::child(ItemID id) const
 {
-    if (id != 0)
-    {
-        //  look for the child in each container; return if found
-        findret(m_visible_canvases)
-        findret(m_invisible_canvases)
-        findret(m_visible_items)
-        findret(m_invisible_items)
-    }
+    return (id != 0 && id <= m_children.size()) ? m_children[id - 1].get() : nullptr;
+}
+
+WidgetItem* Canvas::hovered_child() const
+{
+    return child(m_hovered);
+}
+
+bool Canvas::is_focus_scope() const
+{
+    return m_focus_scope;
+}
+
+bool Canvas::is_opaque() const
+{
+    if (!Super::is_opaque())
+        return false;
+    if (!m_texture)
+        return true;    //  the background is drawn in place
     
-    return nullptr;
+    SDL_BlendMode mode;
+    if (SDL_GetTextureBlendMode(m_texture.get(), &mode) != 0)
+        return false;
+    return mode == SDL_BLENDMODE_NONE || mode == SDL_BLENDMODE_BLEND;
+}
+
+FocusManager* Canvas::focus_manager()
+{
+    return m_parent ? m_parent->focus_manager() : nullptr;
 }
 
 void Canvas::foreach_child(std::function<void(WidgetItem*)> f, ChildFlags flags) const
 {
-    //  iterate over containers based on flags
-    if (flags & VISIBLE)
+    for_each_child(f, flags);
+}
+
+bool Canvas::needs_update() const
+{
+    return m_redraw || m_subtree_dirty || !SDL_RectEmpty(&m_damage);
+}
+
+/// GUI functions:
+template<class Event, class Handler>
+bool Canvas::dispatch(Event const& event, Handler&& handle)
+{
+    //  topmost (last added) children first; stop at the first one that handles the event
+    //  (indices are taken before calling handlers, so handlers may add children)
+    if (!m_spatial_index)
     {
-        if (flags & ITEMS) { iterate_const(m_visible_items) }
-        else if (flags & CANVASES) { iterate_const(m_visible_canvases) }
-        else
-        {
-            //  only VISIBLE was specified but neither ITEMS/CANVASES were... so apply `f` to all
-            iterate_const(m_visible_canvases)
-            iterate_const(m_visible_items)
-        }
+        for (auto i = m_children.size(); i-- > 0;)
+            if (m_visible[i] && handle(m_children[i].get()))
+                return true;
+        return false;
     }
     
-    if (flags & INVISIBLE)
-    {
-        if (flags & ITEMS) { iterate_const(m_invisible_items) }
-        else if (flags & CANVASES) { iterate_const(m_invisible_canvases) }
-        else
-        {
-            iterate_const(m_invisible_canvases)
-            iterate_const(m_invisible_items)
-        }
-    }
+    //  copy the candidates first: handlers may move children, which updates the index
+    std::vector<ItemID> candidates;
+    m_spatial_index->query(event.pos.x, event.pos.y, candidates);
+    for (auto it = candidates.rbegin(); it != candidates.rend(); ++it)
+        if (m_visible[*it - 1] && handle(m_children[*it - 1].get()))
+            return true;
+    return false;
 }
 
-/// GUI functions:
 bool Canvas::handle_mouse_event(MouseEvent const& event)
 {
     if (!Super::handle_mouse_event(event))
+    {
+        m_hit = 0;
         return false;
+    }
 
     //  since canvas deals with offset'ed items, apply an offset to the event
     const auto offset_event = event.offset(m_dimensions.x, m_dimensions.y);
-    foreach_child(std::bind(&WidgetItem::handle_mouse_event, _1, std::cref(offset_event)), VISIBLE);
+    m_hit = capture_mouse_event(offset_event) ? 0 : route_mouse_event(offset_event);
     return true;
 }
 
@@ -360,34 +483,209 @@ bool Canvas::handle_wheel_event(WheelEvent const& event)
         return false;
 
     const auto offset_event = event.offset(m_dimensions.x, m_dimensions.y);
-    foreach_child(std::bind(&WidgetItem::handle_wheel_event, _1, std::cref(offset_event)), VISIBLE);
+    if (!capture_wheel_event(offset_event))
+        dispatch(offset_event, [&offset_event](WidgetItem* child) { return child->handle_wheel_event(offset_event); });
     return true;
 }
 
-void Canvas::update(Renderer const& renderer)
+void Canvas::update_hover(MouseEvent const& event)
 {
-    for (auto& pair : m_visible_canvases)
-        pair.second->update(renderer);
+    const auto offset_event = event.offset(m_dimensions.x, m_dimensions.y);
+    if (m_hit != m_hovered)
+    {
+        auto left = child(m_hovered);
+        m_hovered = m_hit;
+        if (left)
+            left->handle_mouse_leave(offset_event);
+        if (auto entered = child(m_hovered))
+            entered->handle_mouse_enter(offset_event);
+    }
     
-    if (m_redraw)
+    //  the hovered child handled the same event, so its own hit is up to date
+    if (m_hovered && m_is_canvas[m_hovered - 1])
+        static_cast<Canvas*>(m_children[m_hovered - 1].get())->update_hover(offset_event);
+}
+
+void Canvas::handle_mouse_leave(MouseEvent const& event)
+{
+    if (auto left = child(m_hovered))
     {
-        m_redraw = false;
-        perform_redraw(m_texture ? TargetWrapper{renderer, m_texture} : renderer);
+        m_hovered = 0;
+        left->handle_mouse_leave(event.offset(m_dimensions.x, m_dimensions.y));
     }
+    Super::handle_mouse_leave(event);
+}
+
+bool Canvas::capture_mouse_event(MouseEvent const&)
+{
+    return false;
+}
+
+bool Canvas::capture_wheel_event(WheelEvent const&)
+{
+    return false;
+}
+
+void Canvas::update(Renderer const& renderer)
+{
+    if (!needs_update())
+        return; //  nothing changed in this subtree
+    
+    update_children(renderer);
+    
+    //  texture-less canvases are redrawn along with their parent, which their damage was passed on to
+    const auto region = consume_damage();
+    if (m_texture && !SDL_RectEmpty(&region))
+        perform_redraw(TargetWrapper{renderer, m_texture}, region);
 }
 
 void Canvas::render(Renderer const& renderer) const
 {
     if (m_texture)
-        SDL_RenderCopy(renderer.get(), m_texture.get(), nullptr, &m_dimensions);
+    {
+        render_texture(renderer, m_texture, m_dimensions);
+        return;
+    }
+    
+    //  draw in place instead: the draw calls depend on the context, so they can't be replayed elsewhere
+    if (auto list = DisplayList::recording())
+        list->mark_volatile();
+    
+    ContextWrapper context{renderer, m_dimensions};
+    if (!context)
+        return; //  entirely clipped
+    
+    if (m_background_color.a)
+        draw_filled_rect(renderer, {0, 0, m_dimensions.w, m_dimensions.h}, m_background_color);
+    if (m_on_redraw)
+        m_on_redraw(renderer);
+    else
+        render_children(renderer);
 }
 
 void Canvas::render_children(Renderer const& renderer) const
 {
-    foreach_child(std::bind(&WidgetItem::render, _1, std::cref(renderer)), VISIBLE);
+    if (m_batching)
+    {
+        RenderBatch batch{renderer};
+        draw_children(renderer);
+    }
+    else
+    {
+        draw_children(renderer);
+    }
 }
 
 /// helper functions:
+void Canvas::draw_children(Renderer const& renderer) const
+{
+    SDL_Rect area;
+    const bool cull = m_viewport_culling && visible_area(renderer, area);
+    if (cull && SDL_RectEmpty(&area))
+        return; //  everything is clipped away
+    
+    if (m_occlusion_culling)
+        find_occluded(cull ? &area : nullptr);
+    
+    auto const& occluded = m_occluded;
+    auto const occlusion = m_occlusion_culling;
+    auto list = m_display_list.get();
+    for_each_child([&](WidgetItem* child)
+    {
+        const std::size_t index = child->id - 1;
+        auto const& dims = child->m_dimensions;
+        if (cull && !SDL_RectEmpty(&dims) && !SDL_HasIntersection(&dims, &area))
+            return;
+        if (occlusion && occluded[index])
+            return;
+        
+        if (!list)
+        {
+            child->render(renderer);
+        }
+        else if (list->is_recorded(index))
+        {
+            list->replay(renderer, index);
+        }
+        else if (list->is_volatile(index))
+        {
+            child->render(renderer);
+        }
+        else
+        {
+            list->begin(index);
+            child->render(renderer);
+            list->end();
+        }
+    }, VISIBLE);
+}
+
+bool Canvas::visible_area(Renderer const& renderer, SDL_Rect& area)
+{
+    auto& state = RenderState::of(renderer.get());
+    const auto viewport = state.viewport();
+    if (SDL_RectEmpty(&viewport))
+        return false;   //  e.g. no renderer
+    
+    area = {0, 0, viewport.w, viewport.h};
+    const auto clip = state.clip();
+    if (!SDL_RectEmpty(&clip) && !SDL_IntersectRect(&area, &clip, &area))
+        area = {0, 0, 0, 0};
+    return true;
+}
+
+void Canvas::find_occluded(SDL_Rect const* area) const
+{
+    //  keep the largest few occluders, so that the pass stays linear in the number of children
+    static constexpr int MAX_OCCLUDERS = 8;
+    SDL_Rect occluders[MAX_OCCLUDERS];
+    int count = 0;
+    
+    auto covers = [](SDL_Rect const& outer, SDL_Rect const& inner)
+    {
+        return outer.x <= inner.x && inner.x + inner.w <= outer.x + outer.w
+            && outer.y <= inner.y && inner.y + inner.h <= outer.y + outer.h;
+    };
+    
+    m_occluded.assign(m_children.size(), false);
+    for (std::size_t i = m_children.size(); i-- > 0; )  //  topmost first
+    {
+        if (!m_visible[i])
+            continue;
+        
+        auto const& child = *m_children[i];
+        SDL_Rect rect = child.m_dimensions;
+        if (SDL_RectEmpty(&rect))
+            continue;   //  may draw anywhere
+        if (area && !SDL_IntersectRect(&rect, area, &rect))
+            continue;   //  culled by the viewport anyway
+        
+        bool covered = false;
+        for (int j = 0; j < count && !covered; ++j)
+            covered = covers(occluders[j], rect);
+        
+        if (covered)
+        {
+            m_occluded[i] = true;
+        }
+        else if (child.is_opaque())
+        {
+            if (count < MAX_OCCLUDERS)
+            {
+                occluders[count++] = rect;
+                continue;
+            }
+            
+            int smallest = 0;
+            for (int j = 1; j < count; ++j)
+                if (occluders[j].w * occluders[j].h < occluders[smallest].w * occluders[smallest].h)
+                    smallest = j;
+            if (rect.w * rect.h > occluders[smallest].w * occluders[smallest].h)
+                occluders[smallest] = rect;
+        }
+    }
+}
+
 Canvas& Canvas::clear(Renderer const& renderer)
 {
     set_render_color(renderer, m_background_color);
@@ -395,13 +693,141 @@ Canvas& Canvas::clear(Renderer const& renderer)
     return *this;
 }
 
-void Canvas::perform_redraw(Renderer const& renderer)
+void Canvas::perform_redraw(Renderer const& renderer, SDL_Rect const& region)
 {
-    this->clear(renderer);
+    const bool partial = m_texture && (region.x > 0 || region.y > 0
+                        || region.x + region.w < m_dimensions.w || region.y + region.h < m_dimensions.h);
+    if (partial)
+    {
+        //  SDL_RenderClear() ignores the clip rect, so fill the damaged region instead
+        RenderState::of(renderer.get()).clip(&region);
+        draw_filled_rect(renderer, region, m_background_color);
+    }
+    else
+    {
+        this->clear(renderer);
+    }
+    
     if (m_on_redraw)
         m_on_redraw(renderer);
     else
         render_children(renderer);  //  default to simply rendering the children
+    
+    if (partial)
+        RenderState::of(renderer.get()).clip(nullptr);
+}
+
+void Canvas::update_children(Renderer const& renderer)
+{
+    if (!m_subtree_dirty)
+        return;
+    
+    //  cleared before updating, so that damage caused by the updates flags the subtree again
+    m_subtree_dirty = false;
+    for (auto id : m_canvas_ids)
+    {
+        if (!m_visible[id - 1])
+            continue;
+        
+        auto canvas = static_cast<Canvas*>(m_children[id - 1].get());
+        if (canvas->needs_update())
+            canvas->update(renderer);
+    }
+}
+
+void Canvas::mark_subtree_dirty()
+{
+    m_subtree_dirty = true;
+    for (auto canvas = m_parent; canvas && !canvas->m_subtree_dirty; canvas = canvas->m_parent)
+        canvas->m_subtree_dirty = true;
+}
+
+SDL_Rect Canvas::consume_damage()
+{
+    auto region = m_redraw ? SDL_Rect{0, 0, m_dimensions.w, m_dimensions.h} : m_damage;
+    m_redraw = false;
+    m_damage = {0, 0, 0, 0};
+    return region;
+}
+
+ItemID Canvas::adopt(WidgetItem* item, bool is_canvas)
+{
+    assert(m_children.size() < std::numeric_limits<ItemID>::max() && "too many children for ItemID");
+    
+    m_children.emplace_back(item);
+    m_visible.push_back(true);
+    m_is_canvas.push_back(is_canvas);
+    
+    const auto id = ItemID(m_children.size());
+    if (is_canvas)
+        m_canvas_ids.push_back(id);
+    
+    item->id = id;
+    item->m_parent = this;
+    m_hit_valid = false;
+    if (m_spatial_index)
+        m_spatial_index->insert(id, item->m_dimensions);
+    damage(item->m_dimensions);
+    return id;
+}
+
+ItemID Canvas::route_mouse_event(MouseEvent const& event)
+{
+    //  fast path: the cursor is still over the last hit child, and nothing above it could cover it
+    if (m_hit_valid && m_hit_exclusive && m_hit && m_visible[m_hit - 1])
+    {
+        auto hit = m_children[m_hit - 1].get();
+        if (hit->is_point_inside(event.pos.x, event.pos.y) && hit->handle_mouse_event(event))
+            return m_hit;
+    }
+    
+    //  marked valid before dispatching, so that handlers changing the children invalidate it again
+    m_hit_valid = true;
+    ItemID hit = 0;
+    dispatch(event, [&event, &hit](WidgetItem* child)
+    {
+        if (!child->handle_mouse_event(event))
+            return false;
+        hit = child->id;
+        return true;
+    });
+    m_hit_exclusive = hit && is_exclusive(hit);
+    return hit;
+}
+
+bool Canvas::is_exclusive(ItemID id) const
+{
+    //  edges are inclusive, as in is_point_inside()
+    const auto& a = m_children[id - 1]->m_dimensions;
+    for (std::size_t i = id; i < m_children.size(); ++i)
+    {
+        if (!m_visible[i])
+            continue;
+        
+        const auto& b = m_children[i]->m_dimensions;
+        if (a.x <= b.x + b.w && b.x <= a.x + a.w && a.y <= b.y + b.h && b.y <= a.y + a.h)
+            return false;
+    }
+    return true;
+}
+
+void Canvas::child_moved(WidgetItem const& item, SDL_Rect const& from)
+{
+    if (m_spatial_index && item.id != 0)
+        m_spatial_index->move(item.id, from, item.m_dimensions);
+    child_changed(item);
+}
+
+void Canvas::child_changed(WidgetItem const&)
+{
+    m_hit_valid = false;
+}
+
+void Canvas::child_invalidated(WidgetItem const& item)
+{
+    if (m_display_list && item.id != 0)
+        m_display_list->invalidate(item.id - 1);
+    damage(item.m_dimensions);
 }
 
 void Canvas::swap(Canvas& canvas) noexcept
@@ -412,9 +838,23 @@ void Canvas::swap(Canvas& canvas) noexcept
     swap(m_texture, canvas.m_texture);
     swap(m_on_redraw, canvas.m_on_redraw);
     swap(m_redraw, canvas.m_redraw);
-    swap(m_visible_items, canvas.m_visible_items);
-    swap(m_invisible_items, canvas.m_invisible_items);
-    swap(m_visible_canvases, canvas.m_visible_canvases);
-    swap(m_invisible_canvases, canvas.m_invisible_canvases);
-    swap(m_id_counter, canvas.m_id_counter);
+    swap(m_damage, canvas.m_damage);
+    swap(m_subtree_dirty, canvas.m_subtree_dirty);
+    swap(m_children, canvas.m_children);
+    swap(m_visible, canvas.m_visible);
+    swap(m_is_canvas, canvas.m_is_canvas);
+    swap(m_canvas_ids, canvas.m_canvas_ids);
+    swap(m_display_list, canvas.m_display_list);
+    swap(m_batching, canvas.m_batching);
+    swap(m_viewport_culling, canvas.m_viewport_culling);
+    swap(m_occlusion_culling, canvas.m_occlusion_culling);
+    swap(m_name_to_id, canvas.m_name_to_id);
+    swap(m_spatial_index, canvas.m_spatial_index);
+    swap(m_hit, canvas.m_hit);
+    swap(m_hit_valid, canvas.m_hit_valid);
+    swap(m_hit_exclusive, canvas.m_hit_exclusive);
+    swap(m_hovered, canvas.m_hovered);
+    swap(m_focus_scope, canvas.m_focus_scope);
+    swap(m_scope_focus, canvas.m_scope_focus);
 }
+
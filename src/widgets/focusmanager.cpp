@@ -0,0 +1,188 @@
+/*
+ *      Copyright (C) 2020 Johnathan Law
+ *
+ *      This file is part of SWL.
+ *
+ *      SWL is free software: you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published by
+ *      the Free Software Foundation, either version 2 of the License, or
+ *      (at your option) any later version.
+ *
+ *      SWL is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ *
+ *      You should have received a copy of the GNU General Public License
+ *      along with SWL.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "widgets/focusmanager.hpp"
+#include "widgets/canvas.hpp"
+
+#include <algorithm>
+
+
+/// constructors:
+FocusManager::FocusManager(Canvas& root) noexcept
+    : m_root{root}
+    , m_focused{nullptr}
+{
+}
+
+/// modifiers:
+bool FocusManager::focus(WidgetItem* item)
+{
+    if (!item)
+    {
+        clear();
+        return true;
+    }
+    
+    if (!can_focus(item))
+    {
+        //  focusing a scope focuses what's inside
+        auto scope = dynamic_cast<Canvas*>(item);
+        if (!scope || !scope->m_focus_scope)
+            return false;
+        
+        item = entry_of(scope);
+        if (!item)
+            return false;
+    }
+    
+    set_focus(item);
+    return true;
+}
+
+void FocusManager::clear()
+{
+    set_focus(nullptr);
+}
+
+bool FocusManager::focus_next()
+{
+    return advance(true);
+}
+
+bool FocusManager::focus_previous()
+{
+    return advance(false);
+}
+
+/// GUI functions:
+bool FocusManager::handle_key_event(KeyEvent const& event)
+{
+    if (m_focused && !can_focus(m_focused))
+        clear();
+    
+    //  bubble from the focused widget up to the root
+    for (WidgetItem* item = m_focused ? m_focused : &m_root; item; item = item->m_parent)
+        if (item->handle_key_event(event))
+            return true;
+    
+    if (event.type == SDL_KEYDOWN && event.keysym.sym == SDLK_TAB && !(event.keysym.mod & (KMOD_CTRL | KMOD_ALT)))
+        return advance(!(event.keysym.mod & KMOD_SHIFT));
+    
+    return false;
+}
+
+/// helper functions:
+bool FocusManager::can_focus(WidgetItem const* item) const
+{
+    if (!item->m_focusable || !item->is_enabled())
+        return false;
+    
+    //  every ancestor must be showing its child, all the way up to the root
+    for (; item->m_parent; item = item->m_parent)
+        if (!item->m_parent->m_visible[item->id - 1])
+            return false;
+    return item == &m_root;
+}
+
+Canvas* FocusManager::scope_of(WidgetItem const* item) const
+{
+    for (auto canvas = item->m_parent; canvas; canvas = canvas->m_parent)
+        if (canvas->m_focus_scope)
+            return canvas;
+    return &m_root;
+}
+
+WidgetItem* FocusManager::entry_of(Canvas* scope) const
+{
+    if (scope->m_scope_focus && can_focus(scope->m_scope_focus) && scope_of(scope->m_scope_focus) == scope)
+        return scope->m_scope_focus;
+    
+    std::vector<WidgetItem*> stops;
+    collect_stops(scope, stops);
+    for (auto stop : stops)
+    {
+        auto nested = dynamic_cast<Canvas*>(stop);
+        auto entry = (nested && nested->m_focus_scope && !can_focus(nested)) ? entry_of(nested) : stop;
+        if (entry)
+            return entry;
+    }
+    return nullptr;
+}
+
+void FocusManager::collect_stops(Canvas const* canvas, std::vector<WidgetItem*>& stops) const
+{
+    canvas->for_each_child([this, &stops](WidgetItem* child)
+    {
+        auto nested = dynamic_cast<Canvas*>(child);
+        if (nested && nested->m_focus_scope)
+        {
+            stops.push_back(child);     //  a nested scope is a single stop
+            return;
+        }
+        
+        if (child->m_focusable && child->is_enabled())
+            stops.push_back(child);
+        if (nested)
+            collect_stops(nested, stops);
+    }, Canvas::VISIBLE);
+}
+
+bool FocusManager::advance(bool forward)
+{
+    auto scope = m_focused ? scope_of(m_focused) : &m_root;
+    
+    std::vector<WidgetItem*> stops;
+    collect_stops(scope, stops);
+    if (stops.empty())
+        return false;
+    
+    //  start after the focused widget (or from either end)
+    const auto n = stops.size();
+    auto it = std::find(stops.begin(), stops.end(), m_focused);
+    std::size_t start = (it != stops.end()) ? (it - stops.begin()) : (forward ? n - 1 : 0);
+    
+    for (std::size_t step = 1; step <= n; ++step)
+    {
+        const auto index = forward ? (start + step) % n : (start + n - step) % n;
+        if (focus(stops[index]))
+            return true;
+    }
+    return false;
+}
+
+void FocusManager::set_focus(WidgetItem* item)
+{
+    if (item == m_focused)
+        return;
+    
+    auto previous = m_focused;
+    m_focused = item;
+    
+    //  scopes remember their last focused widget
+    if (item)
+        for (auto canvas = item->m_parent; canvas; canvas = canvas->m_parent)
+            if (canvas->m_focus_scope)
+                canvas->m_scope_focus = item;
+    
+    if (previous)
+        previous->handle_focus_out();
+    if (item)
+        item->handle_focus_in();
+}
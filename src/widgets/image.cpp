@@ -24,7 +24,7 @@
 /// GUI functions:
 void ImageItem::render(Renderer const& renderer) const
 {
-    SDL_RenderCopy(renderer.get(), m_texture.get(), nullptr, &m_dimensions);
+    render_texture(renderer, m_texture, m_dimensions);
 }
 
 /// convenience functions:
@@ -35,9 +35,19 @@ bool TextButton::handle_mouse_event(MouseEvent const& event)
     return true;
 }
 
+void TextButton::handle_mouse_enter(MouseEvent const& event)
+{
+    entered(event);
+}
+
+void TextButton::handle_mouse_leave(MouseEvent const& event)
+{
+    left(event);
+}
+
 void TextButton::render(Renderer const& renderer) const
 {
     Super::render(renderer);    //  draw button before text
-    draw_text(renderer, m_dimensions, m_font.lock(), text(), m_alignment);
+    render_text(renderer, m_dimensions);
 }
 
@@ -20,6 +20,7 @@
 
 #include "widgets/widgetitem.hpp"
 #include "widgets/canvas.hpp"
+#include "widgets/focusmanager.hpp"
 
 #include "types.hpp"
 #include "utility.hpp"
@@ -34,13 +35,71 @@ WidgetItem::WidgetItem(SDL_Rect const& dimensions, Canvas* parent, std::string c
     : m_dimensions(dimensions)
     , m_parent(parent)
     , m_enabled(true)
+    , m_focusable(false)
 {
     if (parent)
         parent->add_item(name, this);
 }
 
+WidgetItem& WidgetItem::dimensions(SDL_Rect const& dimensions)
+{
+    if (SDL_RectEquals(&dimensions, &m_dimensions))
+        return *this;
+    
+    invalidate();   //  the old area
+    const auto old_dimensions = m_dimensions;
+    m_dimensions = dimensions;
+    if (m_parent)
+        m_parent->child_moved(*this, old_dimensions);
+    invalidate();   //  the new area
+    return *this;
+}
+
 void WidgetItem::show() { if (m_parent) m_parent->show(id); }
 void WidgetItem::hide() { if (m_parent) m_parent->hide(id); }
+void WidgetItem::invalidate() { if (m_parent) m_parent->child_invalidated(*this); }
+
+WidgetItem& WidgetItem::focusable(bool on)
+{
+    m_focusable = on;
+    return *this;
+}
+
+bool WidgetItem::focus()
+{
+    auto manager = m_parent ? m_parent->focus_manager() : nullptr;
+    return manager && manager->focus(this);
+}
+
+void WidgetItem::enable()
+{
+    if (m_enabled)
+        return;
+    
+    m_enabled = true;
+    if (m_parent)
+        m_parent->child_changed(*this);
+    invalidate();
+}
+
+void WidgetItem::disable()
+{
+    if (!m_enabled)
+        return;
+    
+    m_enabled = false;
+    if (m_parent)
+        m_parent->child_changed(*this);
+    invalidate();
+}
+
+
+/// accessors:
+bool WidgetItem::has_focus() const
+{
+    auto manager = m_parent ? m_parent->focus_manager() : nullptr;
+    return manager && manager->focused() == this;
+}
 
 
 /// convenience functions:
@@ -51,4 +110,5 @@ void WidgetItem::swap(WidgetItem& item) noexcept
     swap(m_dimensions, item.m_dimensions);
     swap(m_parent, item.m_parent);
     swap(m_enabled, item.m_enabled);
+    swap(m_focusable, item.m_focusable);
 }